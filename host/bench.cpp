@@ -0,0 +1,688 @@
+/*
+ * NMEA replay and throughput benchmark
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <new>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "pico/stdlib.h"
+#include "host_hal.h"
+#include "gps_oled.h"
+
+// Heap accounting, every C++ allocation in the process goes through here
+
+static size_t sg_nAllocs    = 0;
+static size_t sg_nAllocated = 0;
+static size_t sg_nLive      = 0;
+static size_t sg_nPeak      = 0;
+
+void* operator new(size_t nSize)
+{
+    void* p = malloc(nSize ? nSize : 1);
+    if (nullptr == p)
+    {
+        throw std::bad_alloc();
+    }
+    size_t nUsable = malloc_usable_size(p);
+    ++sg_nAllocs;
+    sg_nAllocated += nUsable;
+    sg_nLive += nUsable;
+    sg_nPeak = std::max(sg_nPeak, sg_nLive);
+    return p;
+}
+
+void* operator new[](size_t nSize)
+{
+    return operator new(nSize);
+}
+
+void operator delete(void* p) noexcept
+{
+    if (nullptr != p)
+    {
+        sg_nLive -= malloc_usable_size(p);
+        free(p);
+    }
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+static uint64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char* const sg_aTypeNames[] = {"GGA", "GSA", "GSV", "RMC", "VTG", "PGTOP", "PCD", "PMTK", "other"};
+static_assert(sizeof(sg_aTypeNames) / sizeof(sg_aTypeNames[0]) == kUnknownSentence + 1, "one name per sentence type");
+
+auto constexpr BENCH_BAUD_RATE = 9600; // for the real time factor, 10 bits per byte
+
+// GPSBench
+//
+// Runs one log through six stages: the streaming parser alone, the
+// stringstream split it replaced, sentence type dispatch against the string
+// map it replaced, coordinate conversion against the strtod() version it
+// replaced, the sentence handlers plus UI rendering for every data callback,
+// and the full RX pipeline from the emulated UART DMA ring through GPS::Run().
+//
+class GPSBench
+{
+public:
+    GPSBench(FILE* pOut, uint nIterations)
+        : m_pOut(pOut),
+          m_nIterations(nIterations)
+    {
+    }
+
+    bool Run(const char* pszPath);
+
+private:
+    void parse();
+    void split();
+    void dispatch();
+    void degrees();
+    void process();
+    void pipeline();
+
+    FILE* m_pOut;
+    uint m_nIterations;
+    std::string m_strLog;
+    std::vector<NMEASentence> m_vSentences;
+};
+
+bool GPSBench::Run(const char* pszPath)
+{
+    FILE* pFile = fopen(pszPath, "rb");
+    if (nullptr == pFile)
+    {
+        perror(pszPath);
+        return false;
+    }
+    m_strLog.clear();
+    char aBuf[4096];
+    size_t nRead;
+    while ((nRead = fread(aBuf, 1, sizeof(aBuf), pFile)) > 0)
+    {
+        m_strLog.append(aBuf, nRead);
+    }
+    fclose(pFile);
+
+    const char* pszName = strrchr(pszPath, '/');
+    fprintf(m_pOut, "%s: %zu bytes\n", pszName ? pszName + 1 : pszPath, m_strLog.size());
+    parse();
+    split();
+    dispatch();
+    degrees();
+    process();
+    pipeline();
+    fprintf(m_pOut, "\n");
+    return true;
+}
+
+// Consumes results so timed loops cannot be dropped
+static volatile int32_t sg_nSink;
+
+// The parser as drainRx drives it, skipping to the next line or '$' after a rejection
+void GPSBench::parse()
+{
+    uint64_t nBest    = UINT64_MAX;
+    size_t nRejected  = 0;
+    size_t nAllocs    = 0;
+    size_t nAllocated = 0;
+    for (uint n = 0; n < m_nIterations; ++n)
+    {
+        m_vSentences.assign(m_strLog.size() / 8 + 1, NMEASentence());
+        size_t nSentences = 0;
+        nRejected         = 0;
+        bool bDiscard     = false;
+        NMEAParser parser;
+        parser.Begin(&m_vSentences[0]);
+
+        size_t nAllocsStart    = sg_nAllocs;
+        size_t nAllocatedStart = sg_nAllocated;
+        uint64_t nStart        = nowNs();
+        for (char ch : m_strLog)
+        {
+            if (bDiscard)
+            {
+                if (ch != '$')
+                {
+                    bDiscard = (ch != '\n');
+                    continue;
+                }
+                bDiscard = false;
+            }
+            switch (parser.Feed(ch))
+            {
+            case NMEAParser::kSentence:
+                parser.Begin(&m_vSentences[++nSentences]);
+                break;
+            case NMEAParser::kBad:
+            case NMEAParser::kOverlength:
+                ++nRejected;
+                parser.Begin(&m_vSentences[nSentences]);
+                if (ch == '$')
+                {
+                    parser.Feed(ch); // the next sentence cut this one short
+                }
+                else
+                {
+                    bDiscard = (ch != '\n');
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        nBest      = std::min(nBest, nowNs() - nStart);
+        nAllocs    = sg_nAllocs - nAllocsStart;
+        nAllocated = sg_nAllocated - nAllocatedStart;
+        m_vSentences.resize(nSentences);
+    }
+
+    fprintf(m_pOut,
+            "  parse     %6zu sentences  %zu rejected  %.1f ns/sentence  %.1f MB/s  %zu allocations  %zu bytes\n",
+            m_vSentences.size(),
+            nRejected,
+            m_vSentences.empty() ? 0.0 : (double)nBest / m_vSentences.size(),
+            nBest ? m_strLog.size() * 1e3 / nBest : 0.0,
+            nAllocs,
+            nAllocated);
+}
+
+// Validation and field split as GPS::processSentence() did them before the
+// streaming parser, on a copy of the line with its CRLF, returning the
+// number of fields or 0 if the line is rejected
+static std::string checkSumViaStream(const std::string& strSentence)
+{
+    uint8_t check = 0;
+    for (const char& c : strSentence)
+    {
+        check ^= (uint8_t)c;
+    }
+    std::stringstream oss;
+    oss << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << (unsigned int)check;
+    return oss.str();
+}
+
+static size_t splitViaStream(std::string strSentence)
+{
+    size_t nLen = strSentence.size();
+    if (nLen < 6 || strSentence[0] != '$' || strSentence.substr(nLen - 2, 2) != "\r\n" || strSentence[nLen - 5] != '*')
+    {
+        return 0;
+    }
+    if (checkSumViaStream(strSentence.substr(1, nLen - 6)) != strSentence.substr(nLen - 4, 2))
+    {
+        return 0;
+    }
+    strSentence = strSentence.substr(0, nLen - 5);
+
+    std::vector<std::string> vElems;
+    std::stringstream s_stream(strSentence);
+    while (s_stream.good())
+    {
+        std::string substr;
+        getline(s_stream, substr, ',');
+        vElems.push_back(substr);
+    }
+    return vElems.size();
+}
+
+// The log a line at a time through splitViaStream(), each line copied out
+// into a std::string as GPS::getSentence() did
+void GPSBench::split()
+{
+    uint64_t nBest    = UINT64_MAX;
+    size_t nSentences = 0;
+    size_t nRejected  = 0;
+    size_t nAllocs    = 0;
+    size_t nAllocated = 0;
+    std::string strLine;
+    for (uint n = 0; n < m_nIterations; ++n)
+    {
+        nSentences             = 0;
+        nRejected              = 0;
+        size_t nAllocsStart    = sg_nAllocs;
+        size_t nAllocatedStart = sg_nAllocated;
+        uint64_t nStart        = nowNs();
+        for (size_t nPos = 0; nPos < m_strLog.size();)
+        {
+            size_t nEnd = m_strLog.find('\n', nPos);
+            nEnd        = (std::string::npos == nEnd) ? m_strLog.size() : nEnd + 1;
+            strLine.assign(m_strLog, nPos, nEnd - nPos);
+            size_t nFields = splitViaStream(strLine);
+            sg_nSink       = nFields;
+            nFields ? ++nSentences : ++nRejected;
+            nPos = nEnd;
+        }
+        nBest      = std::min(nBest, nowNs() - nStart);
+        nAllocs    = sg_nAllocs - nAllocsStart;
+        nAllocated = sg_nAllocated - nAllocatedStart;
+    }
+
+    // Lines cut short by a '$' are lost whole here rather than restarted
+    fprintf(m_pOut,
+            "  split     %6zu sentences  %zu rejected  %.1f ns/sentence  %.1f MB/s  %zu allocations  %zu bytes\n",
+            nSentences,
+            nRejected,
+            nSentences ? (double)nBest / nSentences : 0.0,
+            nBest ? m_strLog.size() * 1e3 / nBest : 0.0,
+            nAllocs,
+            nAllocated);
+}
+
+// Header to sentence type, by nmea_sentence_type() and by the std::map of
+// "$GPxxx" strings that GPS::processSentence() used to search, with the
+// std::string key the old split built for the header field and its
+// find() then at()
+void GPSBench::dispatch()
+{
+    static const std::map<std::string, eSentenceType> mapTypes = {
+        {"$GPGGA", kGGA  },
+        {"$GPGSA", kGSA  },
+        {"$GPGSV", kGSV  },
+        {"$GPRMC", kRMC  },
+        {"$GPVTG", kVTG  },
+        {"$PGTOP", kPGTOP},
+        {"$PCD",   kPCD  },
+    };
+
+    uint64_t nBestKey = UINT64_MAX;
+    uint64_t nBestMap = UINT64_MAX;
+    size_t nKnownKey  = 0;
+    size_t nKnownMap  = 0;
+    for (uint n = 0; n < m_nIterations; ++n)
+    {
+        uint64_t nStart = nowNs();
+        nKnownKey       = 0;
+        for (const auto& oSentence : m_vSentences)
+        {
+            eTalker talker;
+            nKnownKey += nmea_sentence_type(oSentence[0], talker) != kUnknownSentence;
+        }
+        uint64_t nKeyed = nowNs();
+        nKnownMap       = 0;
+        for (const auto& oSentence : m_vSentences)
+        {
+            std::string strHeader(oSentence[0]);
+            if (mapTypes.find(strHeader) != mapTypes.end())
+            {
+                sg_nSink = mapTypes.at(strHeader);
+                ++nKnownMap;
+            }
+        }
+        nBestKey = std::min(nBestKey, nKeyed - nStart);
+        nBestMap = std::min(nBestMap, nowNs() - nKeyed);
+    }
+
+    // The map only knows GP talkers, so it can recognise fewer sentences
+    fprintf(m_pOut,
+            "  dispatch  packed key %.1f ns/sentence (%zu known)  string map %.1f ns/sentence (%zu known)\n",
+            m_vSentences.empty() ? 0.0 : (double)nBestKey / m_vSentences.size(),
+            nKnownKey,
+            m_vSentences.empty() ? 0.0 : (double)nBestMap / m_vSentences.size(),
+            nKnownMap);
+}
+
+// (D)DDMM.mmmm to 1e-7 degrees through strtod() and doubles, as
+// GPS::convertToDegrees() did but keeping the fractional minutes
+static int32_t degreesViaDouble(std::string_view svField)
+{
+    char szField[24];
+    size_t nLen = std::min(svField.size(), sizeof(szField) - 1);
+    svField.copy(szField, nLen);
+    szField[nLen]   = '\0';
+    double dRaw     = strtod(szField, nullptr);
+    double dDegrees = floor(dRaw / 100);
+    return (int32_t)((dDegrees + (dRaw - dDegrees * 100) / 60) * 1e7 + 0.5);
+}
+
+// Latitude and longitude fields of the GGA and RMC sentences, by
+// nmea_to_degrees() and by strtod()
+void GPSBench::degrees()
+{
+    std::vector<std::string_view> vFields;
+    for (const auto& oSentence : m_vSentences)
+    {
+        if (oSentence.eType == kGGA || oSentence.eType == kRMC)
+        {
+            size_t nLat = (oSentence.eType == kGGA) ? 2 : 3;
+            vFields.push_back(oSentence[nLat]);
+            vFields.push_back(oSentence[nLat + 2]);
+        }
+    }
+
+    uint64_t nBestInt    = UINT64_MAX;
+    uint64_t nBestDouble = UINT64_MAX;
+    size_t nDiffer       = 0;
+    for (uint n = 0; n < m_nIterations; ++n)
+    {
+        uint64_t nStart = nowNs();
+        for (auto svField : vFields)
+        {
+            int32_t nDegrees = 0;
+            nmea_to_degrees(svField, nDegrees);
+            sg_nSink = nDegrees;
+        }
+        uint64_t nInteger = nowNs();
+        for (auto svField : vFields)
+        {
+            sg_nSink = degreesViaDouble(svField);
+        }
+        nBestInt    = std::min(nBestInt, nInteger - nStart);
+        nBestDouble = std::min(nBestDouble, nowNs() - nInteger);
+    }
+    for (auto svField : vFields)
+    {
+        int32_t nDegrees = 0;
+        nDiffer += nmea_to_degrees(svField, nDegrees) && nDegrees != degreesViaDouble(svField);
+    }
+
+    fprintf(m_pOut,
+            "  degrees   %zu fields  integer %.1f ns/field  strtod %.1f ns/field  %zu differ\n",
+            vFields.size(),
+            vFields.empty() ? 0.0 : (double)nBestInt / vFields.size(),
+            vFields.empty() ? 0.0 : (double)nBestDouble / vFields.size(),
+            nDiffer);
+}
+
+// Sentence handlers and, whenever a data callback would fire, a UI frame
+void GPSBench::process()
+{
+    uint64_t aTypeNs[kUnknownSentence + 1] = {};
+    size_t aTypeCount[kUnknownSentence + 1] = {};
+    std::vector<uint64_t> vFrameNs;
+    uint64_t nBest     = UINT64_MAX;
+    size_t nAllocs     = 0;
+    size_t nAllocated  = 0;
+    size_t nPeak       = 0;
+    uint32_t nI2CBytes = 0;
+    uint32_t nI2CXfers = 0;
+    vFrameNs.reserve(m_vSentences.size() * m_nIterations); // keep the timing out of the heap counts
+
+    for (uint n = 0; n < m_nIterations; ++n)
+    {
+        GPS::Shared spGPS         = std::make_shared<GPS>(uart0);
+        SSD1306::Shared spDisplay = std::make_shared<SSD1306_I2C>(128, 64, i2c0);
+        GPS_OLED::Shared spDevice = std::make_shared<GPS_OLED>(spDisplay, spGPS, nullptr);
+        spDevice->Initialize();
+        host_i2c_reset_stats(i2c0);
+
+        size_t nAllocsStart    = sg_nAllocs;
+        size_t nAllocatedStart = sg_nAllocated;
+        size_t nLiveStart      = sg_nLive;
+        sg_nPeak               = sg_nLive;
+
+        uint64_t nTotal = 0;
+        for (auto& oSentence : m_vSentences)
+        {
+            oSentence.nTimestamp = time_us_64(); // as drainRx() stamps it
+            uint64_t nStart      = nowNs();
+            spGPS->processSentence(oSentence);
+            uint64_t nParsed = nowNs();
+            aTypeNs[oSentence.eType] += nParsed - nStart;
+            ++aTypeCount[oSentence.eType];
+
+            if (spGPS->m_bSendGpsData)
+            {
+                spGPS->m_bSendGpsData = false;
+                spDevice->updateUI(spGPS->m_gpsData);
+                uint64_t nDrawn = nowNs();
+                vFrameNs.push_back(nDrawn - nParsed);
+                nParsed = nDrawn;
+            }
+            nTotal += nParsed - nStart;
+        }
+
+        nBest      = std::min(nBest, nTotal);
+        nAllocs    = sg_nAllocs - nAllocsStart;
+        nAllocated = sg_nAllocated - nAllocatedStart;
+        nPeak      = sg_nPeak - nLiveStart;
+        nI2CBytes  = host_i2c_stats(i2c0).nBytes;
+        nI2CXfers  = host_i2c_stats(i2c0).nTransactions;
+    }
+
+    fprintf(m_pOut, "  type       count  ns/sentence\n");
+    for (int i = 0; i <= kUnknownSentence; ++i)
+    {
+        if (aTypeCount[i] > 0)
+        {
+            fprintf(m_pOut, "  %-7s %8zu  %11.0f\n", sg_aTypeNames[i], aTypeCount[i] / m_nIterations, (double)aTypeNs[i] / aTypeCount[i]);
+        }
+    }
+    fprintf(m_pOut,
+            "  process   %.0f sentences/s including UI\n",
+            nBest ? m_vSentences.size() * 1e9 / nBest : 0.0);
+    fprintf(m_pOut, "  heap      %zu allocations  %zu bytes  peak %zu bytes above baseline\n", nAllocs, nAllocated, nPeak);
+
+    if (!vFrameNs.empty())
+    {
+        std::sort(vFrameNs.begin(), vFrameNs.end());
+        uint64_t nSum = 0;
+        for (auto nNs : vFrameNs)
+        {
+            nSum += nNs;
+        }
+        size_t nFrames = vFrameNs.size() / m_nIterations;
+        fprintf(m_pOut,
+                "  frames    %zu  mean %.0f ns  p50 %llu ns  p99 %llu ns  max %llu ns  I2C %u bytes  %.1f transactions/frame\n",
+                nFrames,
+                (double)nSum / vFrameNs.size(),
+                (unsigned long long)vFrameNs[vFrameNs.size() / 2],
+                (unsigned long long)vFrameNs[vFrameNs.size() * 99 / 100],
+                (unsigned long long)vFrameNs.back(),
+                nFrames ? (uint32_t)(nI2CBytes / nFrames) : 0,
+                nFrames ? (double)nI2CXfers / nFrames : 0.0);
+    }
+}
+
+static void stopGPS(void* pCtx)
+{
+    reinterpret_cast<GPS*>(pCtx)->Stop();
+}
+
+// Everything from the UART DMA ring onwards, as gps_oled_replay runs it
+void GPSBench::pipeline()
+{
+    uint64_t nBest        = UINT64_MAX;
+    uint32_t nSentences   = 0;
+    uint32_t nDropped     = 0;
+    for (uint n = 0; n < m_nIterations; ++n)
+    {
+        FILE* pLog = fmemopen(const_cast<char*>(m_strLog.data()), m_strLog.size(), "rb");
+        GPS::Shared spGPS         = std::make_shared<GPS>(uart0);
+        SSD1306::Shared spDisplay = std::make_shared<SSD1306_I2C>(128, 64, i2c0);
+        GPS_OLED::Shared spDevice = std::make_shared<GPS_OLED>(spDisplay, spGPS, nullptr);
+        spDevice->Initialize();
+        host_uart_set_source(uart0, pLog);
+        host_set_idle_callback(stopGPS, spGPS.get());
+
+        uint64_t nStart = nowNs();
+        spGPS->Run();
+        nBest = std::min(nBest, nowNs() - nStart);
+
+        GPSRxStats rxStats = spGPS->GetRxStats();
+        nSentences         = rxStats.nSentences;
+        nDropped           = rxStats.nDroppedSentences;
+        host_set_idle_callback(nullptr, nullptr);
+        host_uart_set_source(uart0, nullptr);
+        fclose(pLog);
+    }
+
+    double dAirSeconds = m_strLog.size() * 10.0 / BENCH_BAUD_RATE;
+    fprintf(m_pOut,
+            "  pipeline  %u sentences  %u dropped  %.0f sentences/s  %.0fx real time at %d baud\n",
+            nSentences,
+            nDropped,
+            nBest ? nSentences * 1e9 / nBest : 0.0,
+            nBest ? dAirSeconds * 1e9 / nBest : 0.0,
+            BENCH_BAUD_RATE);
+}
+
+// Framebuf primitives on a 128x64 MVLSB buffer, alternating the colour so
+// every call changes the pixels it covers
+static void benchDraw(FILE* pOut, uint nIterations)
+{
+    auto constexpr BENCH_DRAW_CALLS = 20000;
+    struct DrawOp
+    {
+        const char* pszName;
+        void (*pDraw)(Framebuf& fb, uint n);
+    };
+    static const DrawOp aOps[] = {
+        {"fill",
+         [](Framebuf& fb, uint n) {
+             fb.fill(n & 1);
+         }},
+        {"fillrect",
+         [](Framebuf& fb, uint n) {
+             fb.fillrect(3, 5, 97, 38, n & 1);
+         }},
+        {"hline",
+         [](Framebuf& fb, uint n) {
+             fb.hline(1, n % 64, 126, n & 1);
+         }},
+        {"vline",
+         [](Framebuf& fb, uint n) {
+             fb.vline(n % 128, 3, 58, n & 1);
+         }},
+        {"rect",
+         [](Framebuf& fb, uint n) {
+             fb.rect(2, 3, 120, 57, n & 1);
+         }},
+        {"text",
+         [](Framebuf& fb, uint n) {
+             fb.text("12:34:56", n % 64, n % 56, n & 1);
+         }},
+        {"line",
+         [](Framebuf& fb, uint n) {
+             fb.line(0, n % 64, 127, 63 - n % 64, n & 1);
+         }},
+        {"ellipse",
+         [](Framebuf& fb, uint n) {
+             fb.ellipse(64, 32, 30, 30 - n % 8, n & 1);
+         }},
+    };
+
+    Framebuf fb;
+    fb.Initialize(128, 64, MVLSB);
+    fprintf(pOut, "drawing: 128x64 MVLSB\n");
+    for (const auto& op : aOps)
+    {
+        uint64_t nBest = UINT64_MAX;
+        for (uint n = 0; n < nIterations; ++n)
+        {
+            uint64_t nStart = nowNs();
+            for (uint i = 0; i < BENCH_DRAW_CALLS; ++i)
+            {
+                op.pDraw(fb, i);
+            }
+            nBest = std::min(nBest, nowNs() - nStart);
+            fb.clear_dirty();
+        }
+        fprintf(pOut, "  %-8s  %6.1f ns/call\n", op.pszName, (double)nBest / BENCH_DRAW_CALLS);
+    }
+    fprintf(pOut, "\n");
+}
+
+static void usage(const char* pszProgram)
+{
+    fprintf(stderr,
+            "usage: %s [-n iterations] [log.nmea ...]\n"
+            "  with no logs the checked-in corpus in %s is used\n",
+            pszProgram,
+            GPS_OLED_CORPUS_DIR);
+}
+
+int main(int argc, char** argv)
+{
+    uint nIterations = 5;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            nIterations = std::max(1ul, strtoul(optarg, nullptr, 0));
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> vLogs(argv + optind, argv + argc);
+    if (vLogs.empty())
+    {
+        for (auto pszName : {"gp_1hz.nmea", "gp_10hz.nmea", "gn_1hz.nmea", "corrupted.nmea"})
+        {
+            vLogs.push_back(std::string(GPS_OLED_CORPUS_DIR "/") + pszName);
+        }
+    }
+
+    // The GPS code prints every sentence, keep that out of the report but
+    // still pay for the formatting as the device does
+    FILE* pOut = fdopen(dup(STDOUT_FILENO), "w");
+    freopen("/dev/null", "w", stdout);
+
+    uart_init(uart0, BENCH_BAUD_RATE);
+    i2c_init(i2c0, 400 * 1000);
+
+    benchDraw(pOut, nIterations);
+
+    GPSBench bench(pOut, nIterations);
+    bool bOK = true;
+    for (const auto& strLog : vLogs)
+    {
+        bOK &= bench.Run(strLog.c_str());
+    }
+    fclose(pOut);
+    return bOK ? 0 : 1;
+}
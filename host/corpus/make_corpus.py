@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+#
+# Generate the benchmark NMEA and UBX corpus.  Output is deterministic so the
+# checked-in files only change when this script does.
+#
+# (c) 2025 Erik Tkal
+#
+
+import math
+import random
+import struct
+
+
+def checksum(body):
+    cs = 0
+    for c in body:
+        cs ^= ord(c)
+    return '$%s*%02X\r\n' % (body, cs)
+
+
+def fmt_time(t):
+    s = int(t)
+    return '%02d%02d%02d.%02d' % ((12 + s // 3600) % 24, (s // 60) % 60, s % 60, int(round((t - s) * 100)) % 100)
+
+
+def fmt_lat(deg):
+    h = 'N' if deg >= 0 else 'S'
+    deg = abs(deg)
+    return '%02d%07.4f,%s' % (int(deg), (deg - int(deg)) * 60, h)
+
+
+def fmt_lon(deg):
+    h = 'E' if deg >= 0 else 'W'
+    deg = abs(deg)
+    return '%03d%07.4f,%s' % (int(deg), (deg - int(deg)) * 60, h)
+
+
+class Sky:
+    # Satellites per talker with slowly drifting positions and noisy SNR
+    def __init__(self, rng, talker, prns):
+        self.rng = rng
+        self.talker = talker
+        self.sats = [[prn, rng.randint(5, 85), rng.randint(0, 359), rng.randint(20, 48)] for prn in prns]
+
+    def step(self):
+        for s in self.sats:
+            s[2] = (s[2] + 1) % 360 if self.rng.random() < 0.05 else s[2]
+            s[3] = max(0, min(55, s[3] + self.rng.randint(-2, 2)))
+
+    def used(self):
+        return [s[0] for s in self.sats if s[3] >= 25][:12]
+
+    def gsv(self, signal=None):
+        n = len(self.sats)
+        total = (n + 3) // 4
+        out = []
+        for i in range(total):
+            fields = ['%sGSV' % self.talker, str(total), str(i + 1), '%02d' % n]
+            for s in self.sats[i * 4:i * 4 + 4]:
+                snr = '%02d' % s[3] if s[3] > 0 else ''
+                fields += ['%02d' % s[0], '%02d' % s[1], '%03d' % s[2], snr]
+            if signal is not None:
+                fields.append(signal)
+            out.append(checksum(','.join(fields)))
+        return out
+
+
+def gsa(talker, used, system_id=None):
+    prns = ['%02d' % p for p in used] + [''] * (12 - len(used))
+    fields = ['%sGSA' % talker, 'A', '3'] + prns + ['1.8', '1.0', '1.5']
+    if system_id is not None:
+        fields.append(system_id)
+    return checksum(','.join(fields))
+
+
+def fix(talker, t, lat, lon, alt, knots, course, nsats):
+    return [
+        checksum('%sGGA,%s,%s,%s,1,%02d,1.0,%.1f,M,46.9,M,,' % (talker, fmt_time(t), fmt_lat(lat), fmt_lon(lon), nsats, alt)),
+        checksum('%sRMC,%s,A,%s,%s,%.2f,%.2f,160625,,,A' % (talker, fmt_time(t), fmt_lat(lat), fmt_lon(lon), knots, course)),
+        checksum('%sVTG,%.2f,T,,M,%.2f,N,%.2f,K,A' % (talker, course, knots, knots * 1.852)),
+    ]
+
+
+def track(t):
+    # A slow loop around Munich
+    lat = 48.1173 + 0.01 * math.sin(t / 300.0)
+    lon = 11.5167 + 0.01 * math.cos(t / 300.0)
+    return lat, lon, 545.4 + 5 * math.sin(t / 60.0), 12.0 + 3 * math.sin(t / 30.0), (t * 1.2) % 360
+
+
+def gp_log(seconds, rate):
+    rng = random.Random(1)
+    gps = Sky(rng, 'GP', [1, 2, 4, 5, 9, 12, 14, 15, 17, 21, 24, 29])
+    lines = []
+    for tick in range(seconds * rate):
+        t = tick / rate
+        lat, lon, alt, knots, course = track(t)
+        lines += fix('GP', t, lat, lon, alt, knots, course, len(gps.used()))[:3 if rate == 1 else 2]
+        if tick % rate == 0:
+            gps.step()
+            lines.append(gsa('GP', gps.used()))
+            lines += gps.gsv()
+            if tick % (60 * rate) == 0:
+                lines.append(checksum('PGTOP,11,3'))
+    return lines
+
+
+def gn_log(seconds):
+    rng = random.Random(2)
+    skies = [
+        (Sky(rng, 'GP', [2, 5, 7, 13, 15, 18, 20, 24, 29, 30]), '1'),
+        (Sky(rng, 'GL', [65, 66, 72, 73, 80, 81, 82]), '2'),
+        (Sky(rng, 'GA', [3, 5, 8, 13, 15, 24, 27]), '3'),
+        (Sky(rng, 'GB', [6, 9, 14, 16, 19, 26, 28, 33, 36]), '4'),
+    ]
+    lines = []
+    for t in range(seconds):
+        lat, lon, alt, knots, course = track(t)
+        nsats = 0
+        for sky, system_id in skies:
+            sky.step()
+            nsats += len(sky.used())
+        lines += fix('GN', t, lat, lon, alt, knots, course, min(nsats, 99))
+        for sky, system_id in skies:
+            lines.append(gsa('GN', sky.used(), system_id))
+        for sky, system_id in skies:
+            lines += sky.gsv('1')
+    return lines
+
+
+def corrupt(lines, seed):
+    # Bit flips, truncations, lost line endings and runs of binary noise
+    rng = random.Random(seed)
+    out = []
+    for line in lines:
+        r = rng.random()
+        if r < 0.02:
+            i = rng.randrange(1, len(line) - 5)
+            line = line[:i] + chr(ord(line[i]) ^ (1 << rng.randrange(7))) + line[i + 1:]
+        elif r < 0.03:
+            line = line[:rng.randrange(1, len(line) - 2)] + '\r\n'
+        elif r < 0.04:
+            line = line[:-2]
+        elif r < 0.045:
+            line = ''.join(chr(rng.randrange(256)) for _ in range(rng.randrange(8, 200))) + line
+        out.append(line)
+    return out
+
+
+def ubx(cls, msg_id, payload):
+    body = struct.pack('<BBH', cls, msg_id, len(payload)) + payload
+    ck_a = ck_b = 0
+    for b in body:
+        ck_a = (ck_a + b) & 0xff
+        ck_b = (ck_b + ck_a) & 0xff
+    return (b'\xb5\x62' + body + bytes([ck_a, ck_b])).decode('latin-1')
+
+
+def nav_pvt(t, lat, lon, alt, knots, course, nsats):
+    s = int(t)
+    p = bytearray(92)
+    struct.pack_into('<IHBBBBBB', p, 0, s * 1000, 2025, 6, 16, (12 + s // 3600) % 24, (s // 60) % 60, s % 60, 0x07)
+    struct.pack_into('<BBBB', p, 20, 3, 0x01, 0, nsats)
+    struct.pack_into('<iiii', p, 24, int(round(lon * 1e7)), int(round(lat * 1e7)), int((alt + 46.9) * 1000), int(alt * 1000))
+    struct.pack_into('<ii', p, 60, int(knots * 514.444), int(course * 1e5))
+    return ubx(0x01, 0x07, bytes(p))
+
+
+def nav_sat(t, skies):
+    blocks = b''
+    n = 0
+    for sky, gnss_id in skies:
+        used = sky.used()
+        for prn, elev, azim, cno in sky.sats:
+            flags = 0x07 if cno > 0 else 0x01
+            if prn in used:
+                flags |= 0x08
+            blocks += struct.pack('<BBBbhhI', gnss_id, prn if gnss_id != 6 else prn - 64, cno, elev, azim, 0, flags)
+            n += 1
+    return ubx(0x01, 0x35, struct.pack('<IBBH', int(t) * 1000, 1, n, 0) + blocks)
+
+
+def ubx_log(seconds):
+    # NAV-PVT and NAV-SAT with the module's NMEA GGA still enabled, so the
+    # stream interleaves binary frames and text lines
+    rng = random.Random(4)
+    skies = [
+        (Sky(rng, 'GP', [2, 5, 7, 13, 15, 18, 20, 24, 29, 30]), 0),
+        (Sky(rng, 'GL', [65, 66, 72, 73, 80, 81, 82]), 6),
+        (Sky(rng, 'GA', [3, 5, 8, 13, 15, 24, 27]), 2),
+    ]
+    lines = []
+    for t in range(seconds):
+        lat, lon, alt, knots, course = track(t)
+        nsats = 0
+        for sky, gnss_id in skies:
+            sky.step()
+            nsats += len(sky.used())
+        lines.append(nav_pvt(t, lat, lon, alt, knots, course, nsats))
+        lines.append(nav_sat(t, skies))
+        lines.append(fix('GN', t, lat, lon, alt, knots, course, min(nsats, 99))[0])
+    return lines
+
+
+def write(name, lines):
+    with open(name, 'w', encoding='latin-1', newline='') as f:
+        f.writelines(lines)
+
+
+if __name__ == '__main__':
+    write('gp_1hz.nmea', gp_log(300, 1))
+    write('gp_10hz.nmea', gp_log(60, 10))
+    write('gn_1hz.nmea', gn_log(120))
+    write('corrupted.nmea', corrupt(gp_log(300, 1), 3))
+    write('ubx_1hz.ubx', ubx_log(120))
@@ -0,0 +1,953 @@
+/*
+ * Host HAL shim
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/uart.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "host_hal.h"
+
+// Time
+
+static const auto sg_tStart = std::chrono::steady_clock::now();
+
+uint64_t time_us_64()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sg_tStart).count();
+}
+
+absolute_time_t get_absolute_time()
+{
+    return time_us_64();
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms)
+{
+    return time_us_64() + ms * 1000ull;
+}
+
+void sleep_ms(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void sleep_us(uint64_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// UART
+
+struct uart_inst
+{
+    uart_hw_t hw;
+    uint nBaudRate;
+    FILE* pSource;
+    size_t nChunk;
+    bool bSourceDone;
+    uint nLineRate;
+    uint8_t nScramble;
+    FILE* pSink;
+};
+
+uart_inst_t host_uart0_inst = {};
+uart_inst_t host_uart1_inst = {};
+
+uint uart_init(uart_inst_t* uart, uint baudrate)
+{
+    return uart_set_baudrate(uart, baudrate);
+}
+
+uint uart_set_baudrate(uart_inst_t* uart, uint baudrate)
+{
+    uart->nBaudRate = baudrate;
+    return baudrate;
+}
+
+void uart_set_format(uart_inst_t* uart, uint data_bits, uint stop_bits, uart_parity_t parity)
+{
+}
+
+void uart_set_hw_flow(uart_inst_t* uart, bool cts, bool rts)
+{
+}
+
+void uart_set_fifo_enabled(uart_inst_t* uart, bool enabled)
+{
+}
+
+void uart_set_irqs_enabled(uart_inst_t* uart, bool rx_has_data, bool tx_needs_data)
+{
+}
+
+uart_hw_t* uart_get_hw(uart_inst_t* uart)
+{
+    return &uart->hw;
+}
+
+uint uart_get_dreq(uart_inst_t* uart, bool is_tx)
+{
+    return 0;
+}
+
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len)
+{
+    if (nullptr != uart->pSink)
+    {
+        fwrite(src, 1, len, uart->pSink);
+    }
+}
+
+void uart_puts(uart_inst_t* uart, const char* s)
+{
+    uart_write_blocking(uart, reinterpret_cast<const uint8_t*>(s), strlen(s));
+}
+
+void uart_tx_wait_blocking(uart_inst_t* uart)
+{
+    if (nullptr != uart->pSink)
+    {
+        fflush(uart->pSink);
+    }
+}
+
+void host_uart_set_source(uart_inst_t* pUART, FILE* pFile, size_t nChunk)
+{
+    pUART->pSource     = pFile;
+    pUART->nChunk      = std::max<size_t>(nChunk, 1);
+    pUART->bSourceDone = (nullptr == pFile);
+}
+
+void host_uart_set_sink(uart_inst_t* pUART, FILE* pFile)
+{
+    pUART->pSink = pFile;
+}
+
+bool host_uart_source_done(uart_inst_t* pUART)
+{
+    return pUART->bSourceDone;
+}
+
+void host_uart_set_line_rate(uart_inst_t* pUART, uint nBaudRate)
+{
+    pUART->nLineRate = nBaudRate;
+}
+
+// Interrupts, raised synchronously
+
+auto constexpr HOST_IRQ_HANDLERS = 4;
+
+struct HostIRQ
+{
+    bool bEnabled;
+    irq_handler_t apHandlers[HOST_IRQ_HANDLERS];
+};
+
+static HostIRQ sg_aIRQ[NUM_IRQS];
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+    for (auto& pHandler : sg_aIRQ[num].apHandlers)
+    {
+        if (nullptr == pHandler)
+        {
+            pHandler = handler;
+            return;
+        }
+    }
+    fprintf(stderr, "No IRQ handler slots available\n");
+    abort();
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler)
+{
+    for (auto& pHandler : sg_aIRQ[num].apHandlers)
+    {
+        if (handler == pHandler)
+        {
+            pHandler = nullptr;
+        }
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    sg_aIRQ[num].bEnabled = enabled;
+}
+
+static void raiseIRQ(uint num)
+{
+    if (!sg_aIRQ[num].bEnabled)
+    {
+        return;
+    }
+    for (auto pHandler : sg_aIRQ[num].apHandlers)
+    {
+        if (nullptr != pHandler)
+        {
+            pHandler();
+        }
+    }
+}
+
+// DMA, UART to ring buffer and memory to I2C
+
+struct HostDMAChannel
+{
+    bool bClaimed;
+    dma_channel_config config;
+    dma_channel_hw_t hw;
+    uint8_t* pWriteBase;
+    uint32_t nWriteOffset;
+    bool bIRQ0Enabled;
+    bool bIRQ0Pending;
+};
+
+static HostDMAChannel sg_aDMA[NUM_DMA_CHANNELS];
+
+static bool dmaToI2C(HostDMAChannel& ch);
+static bool dmaToSPI(HostDMAChannel& ch);
+
+int dma_claim_unused_channel(bool required)
+{
+    for (int i = 0; i < NUM_DMA_CHANNELS; ++i)
+    {
+        if (!sg_aDMA[i].bClaimed)
+        {
+            sg_aDMA[i] = HostDMAChannel();
+            sg_aDMA[i].bClaimed = true;
+            return i;
+        }
+    }
+    if (required)
+    {
+        fprintf(stderr, "No DMA channels available\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel)
+{
+    sg_aDMA[channel].bClaimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config c = {};
+    c.size               = DMA_SIZE_32;
+    c.read_increment     = true;
+    c.write_increment    = false;
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size)
+{
+    c->size = size;
+}
+
+void channel_config_set_read_increment(dma_channel_config* c, bool incr)
+{
+    c->read_increment = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config* c, bool incr)
+{
+    c->write_increment = incr;
+}
+
+void channel_config_set_ring(dma_channel_config* c, bool write, uint size_bits)
+{
+    c->ring_write = write;
+    c->ring_bits  = size_bits;
+}
+
+void channel_config_set_dreq(dma_channel_config* c, uint dreq)
+{
+    c->dreq = dreq;
+}
+
+void dma_channel_configure(uint channel,
+                           const dma_channel_config* config,
+                           volatile void* write_addr,
+                           const volatile void* read_addr,
+                           uint transfer_count,
+                           bool trigger)
+{
+    HostDMAChannel& ch   = sg_aDMA[channel];
+    ch.config            = *config;
+    ch.pWriteBase        = (uint8_t*)write_addr;
+    ch.nWriteOffset      = 0;
+    ch.hw.read_addr      = (uintptr_t)read_addr;
+    ch.hw.write_addr     = (uintptr_t)write_addr;
+    ch.hw.transfer_count = transfer_count;
+    if (trigger && (dmaToI2C(ch) || dmaToSPI(ch)) && ch.bIRQ0Enabled)
+    {
+        ch.bIRQ0Pending = true;
+        raiseIRQ(DMA_IRQ_0);
+    }
+}
+
+dma_channel_hw_t* dma_channel_hw_addr(uint channel)
+{
+    return &sg_aDMA[channel].hw;
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    return sg_aDMA[channel].hw.transfer_count != 0;
+}
+
+void dma_channel_abort(uint channel)
+{
+    sg_aDMA[channel].hw.transfer_count = 0;
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+    sg_aDMA[channel].hw.transfer_count = trans_count;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+    sg_aDMA[channel].bIRQ0Enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel)
+{
+    return sg_aDMA[channel].bIRQ0Pending;
+}
+
+void dma_channel_acknowledge_irq0(uint channel)
+{
+    sg_aDMA[channel].bIRQ0Pending = false;
+}
+
+// Move bytes from the UART sources into the rings of the channels reading them
+static size_t pumpUARTs()
+{
+    size_t nTotal = 0;
+    for (auto pUART : {uart0, uart1})
+    {
+        if (nullptr == pUART->pSource || pUART->bSourceDone)
+        {
+            continue;
+        }
+        for (auto& ch : sg_aDMA)
+        {
+            if (!ch.bClaimed || ch.hw.read_addr != (uintptr_t)&pUART->hw.dr || 0 == ch.hw.transfer_count)
+            {
+                continue;
+            }
+            uint8_t aChunk[4096];
+            size_t nWant = std::min<size_t>({pUART->nChunk, sizeof(aChunk), ch.hw.transfer_count});
+            size_t nRead = fread(aChunk, 1, nWant, pUART->pSource);
+            if (nRead < nWant && (feof(pUART->pSource) || ferror(pUART->pSource)))
+            {
+                pUART->bSourceDone = true;
+            }
+            uint32_t nMask = ch.config.ring_write ? (1u << ch.config.ring_bits) - 1 : UINT32_MAX;
+            if (0 != pUART->nLineRate && pUART->nLineRate != pUART->nBaudRate)
+            {
+                // Sampled at the wrong rate, mostly noise with the odd framing
+                // that happens to decode as text
+                for (size_t i = 0; i < nRead; ++i)
+                {
+                    pUART->nScramble = pUART->nScramble * 167 + 13;
+                    aChunk[i]        = (aChunk[i] * 29) ^ pUART->nScramble;
+                }
+            }
+            for (size_t i = 0; i < nRead; ++i)
+            {
+                ch.pWriteBase[ch.nWriteOffset & nMask] = aChunk[i];
+                ++ch.nWriteOffset;
+            }
+            ch.hw.write_addr = (uintptr_t)(ch.pWriteBase + (ch.nWriteOffset & nMask));
+            ch.hw.transfer_count -= nRead;
+            nTotal += nRead;
+            break;
+        }
+    }
+    return nTotal;
+}
+
+// Timers
+
+static std::vector<repeating_timer_t*> sg_vTimers;
+static void (*sg_pIdleCB)(void*) = nullptr;
+static void* sg_pIdleCtx         = nullptr;
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out)
+{
+    out->delay_us  = delay_ms * 1000ll;
+    out->callback  = callback;
+    out->user_data = user_data;
+    sg_vTimers.push_back(out);
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t* timer)
+{
+    auto it = std::find(sg_vTimers.begin(), sg_vTimers.end(), timer);
+    if (it == sg_vTimers.end())
+    {
+        return false;
+    }
+    sg_vTimers.erase(it);
+    return true;
+}
+
+void host_set_idle_callback(void (*pCB)(void* pCtx), void* pCtx)
+{
+    sg_pIdleCB  = pCB;
+    sg_pIdleCtx = pCtx;
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp)
+{
+    // Whatever would have arrived while dozing arrives now, then every
+    // timer is considered due.
+    size_t nPumped = pumpUARTs();
+    auto vTimers   = sg_vTimers;
+    for (auto pTimer : vTimers)
+    {
+        if (!pTimer->callback(pTimer))
+        {
+            cancel_repeating_timer(pTimer);
+        }
+    }
+
+    if (0 == nPumped && nullptr != sg_pIdleCB)
+    {
+        bool bActive = false;
+        for (auto pUART : {uart0, uart1})
+        {
+            bActive |= (nullptr != pUART->pSource && !pUART->bSourceDone);
+        }
+        if (!bActive)
+        {
+            sg_pIdleCB(sg_pIdleCtx);
+        }
+    }
+    return true;
+}
+
+// GPIO levels
+
+auto constexpr HOST_NUM_GPIOS = 30;
+
+static bool sg_abGPIO[HOST_NUM_GPIOS];
+
+void gpio_put(uint gpio, bool value)
+{
+    if (gpio < HOST_NUM_GPIOS)
+    {
+        sg_abGPIO[gpio] = value;
+    }
+}
+
+bool gpio_get(uint gpio)
+{
+    return gpio < HOST_NUM_GPIOS && sg_abGPIO[gpio];
+}
+
+// SSD1306 emulation, fed by I2C or SPI
+
+struct HostSSD1306
+{
+    uint8_t aRAM[HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH];
+    uint32_t nDataBytes; // bytes landing in aRAM
+    uint8_t nMemMode;    // 0 horizontal, 1 vertical, 2 page
+    uint8_t nColStart, nColEnd, nCol;
+    uint8_t nPageStart, nPageEnd, nPage;
+    uint8_t nCmd;  // command awaiting parameters
+    uint8_t nArgs; // parameters still expected
+    uint8_t nArgIdx;
+};
+
+static void ssd1306Reset(HostSSD1306* pOLED)
+{
+    pOLED->nMemMode   = 2; // SSD1306 reset state
+    pOLED->nColStart  = 0;
+    pOLED->nColEnd    = HOST_SSD1306_WIDTH - 1;
+    pOLED->nPageStart = 0;
+    pOLED->nPageEnd   = HOST_SSD1306_PAGES - 1;
+}
+
+static uint ssd1306ArgCount(uint8_t nCmd)
+{
+    switch (nCmd)
+    {
+    case 0x20: // memory addressing mode
+    case 0x81: // contrast
+    case 0x8D: // charge pump
+    case 0xA8: // multiplex ratio
+    case 0xD3: // display offset
+    case 0xD5: // clock divide
+    case 0xD9: // pre-charge
+    case 0xDA: // COM pins
+    case 0xDB: // VCOMH deselect
+        return 1;
+    case 0x21: // column address
+    case 0x22: // page address
+    case 0xA3: // vertical scroll area
+        return 2;
+    case 0x29: // vertical and horizontal scroll
+    case 0x2A:
+        return 5;
+    case 0x26: // horizontal scroll
+    case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void ssd1306Command(HostSSD1306* pOLED, uint8_t nByte)
+{
+    if (pOLED->nArgs > 0)
+    {
+        uint nArg = pOLED->nArgIdx++;
+        --pOLED->nArgs;
+        switch (pOLED->nCmd)
+        {
+        case 0x20:
+            pOLED->nMemMode = nByte & 0x03;
+            break;
+        case 0x21:
+            if (0 == nArg)
+            {
+                pOLED->nColStart = pOLED->nCol = nByte & 0x7f;
+            }
+            else
+            {
+                pOLED->nColEnd = nByte & 0x7f;
+            }
+            break;
+        case 0x22:
+            if (0 == nArg)
+            {
+                pOLED->nPageStart = pOLED->nPage = nByte & 0x07;
+            }
+            else
+            {
+                pOLED->nPageEnd = nByte & 0x07;
+            }
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    if (nByte >= 0xB0 && nByte <= 0xB7)
+    {
+        pOLED->nPage = nByte & 0x07; // page mode start page
+    }
+    else if (nByte <= 0x0F)
+    {
+        pOLED->nCol = (pOLED->nCol & 0xF0) | nByte; // page mode lower column
+    }
+    else if (nByte >= 0x10 && nByte <= 0x1F)
+    {
+        pOLED->nCol = ((nByte & 0x07) << 4) | (pOLED->nCol & 0x0F); // page mode upper column
+    }
+    else
+    {
+        pOLED->nCmd    = nByte;
+        pOLED->nArgs   = ssd1306ArgCount(nByte);
+        pOLED->nArgIdx = 0;
+    }
+}
+
+static void ssd1306Data(HostSSD1306* pOLED, uint8_t nByte)
+{
+    pOLED->aRAM[pOLED->nPage * HOST_SSD1306_WIDTH + pOLED->nCol] = nByte;
+    ++pOLED->nDataBytes;
+
+    if (2 == pOLED->nMemMode)
+    {
+        pOLED->nCol = (pOLED->nCol + 1) % HOST_SSD1306_WIDTH;
+    }
+    else if (0 == pOLED->nMemMode)
+    {
+        if (pOLED->nCol++ >= pOLED->nColEnd)
+        {
+            pOLED->nCol  = pOLED->nColStart;
+            pOLED->nPage = (pOLED->nPage >= pOLED->nPageEnd) ? pOLED->nPageStart : pOLED->nPage + 1;
+        }
+    }
+    else
+    {
+        if (pOLED->nPage++ >= pOLED->nPageEnd)
+        {
+            pOLED->nPage = pOLED->nPageStart;
+            pOLED->nCol  = (pOLED->nCol >= pOLED->nColEnd) ? pOLED->nColStart : pOLED->nCol + 1;
+        }
+    }
+}
+
+// I2C, decoded as SSD1306 traffic
+
+struct i2c_inst
+{
+    std::mutex mutex; // the display may be driven from core1
+    i2c_hw_t hw;
+    HostI2CStats stats;
+    HostSSD1306 oled;
+    uint nSkip; // host_i2c_fail(): transactions to let through,
+    uint nFail; // then to refuse
+};
+
+i2c_inst_t host_i2c0_inst;
+i2c_inst_t host_i2c1_inst;
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate)
+{
+    std::lock_guard<std::mutex> lock(i2c->mutex);
+    ssd1306Reset(&i2c->oled);
+    i2c->hw.status = I2C_IC_STATUS_TFE_BITS; // idle, nothing queued
+    i2c->nSkip     = 0;
+    i2c->nFail     = 0;
+    return baudrate;
+}
+
+i2c_hw_t* i2c_get_hw(i2c_inst_t* i2c)
+{
+    return &i2c->hw;
+}
+
+uint i2c_get_dreq(i2c_inst_t* i2c, bool is_tx)
+{
+    return (i2c == i2c0 ? 32 : 34) + (is_tx ? 0 : 1);
+}
+
+// Whether host_i2c_fail() has the next transaction refused, counting it if so
+static bool i2cRefused(i2c_inst_t* i2c)
+{
+    if (i2c->nSkip > 0)
+    {
+        --i2c->nSkip;
+        return false;
+    }
+    if (0 == i2c->nFail)
+    {
+        return false;
+    }
+    --i2c->nFail;
+    ++i2c->stats.nTransactions;
+    return true;
+}
+
+static void i2cTransaction(i2c_inst_t* i2c, const uint8_t* src, size_t len)
+{
+    ++i2c->stats.nTransactions;
+    i2c->stats.nBytes += len;
+
+    // Each control byte has Co (continuation) in bit 7 and D/C# in bit 6.
+    // With Co set a single byte follows before the next control byte,
+    // otherwise the rest of the transaction is all commands or all data.
+    size_t i = 0;
+    while (i < len)
+    {
+        uint8_t nControl = src[i++];
+        bool bData       = nControl & 0x40;
+        size_t nEnd      = (nControl & 0x80) ? std::min(i + 1, len) : len;
+        for (; i < nEnd; ++i)
+        {
+            bData ? ssd1306Data(&i2c->oled, src[i]) : ssd1306Command(&i2c->oled, src[i]);
+        }
+    }
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop)
+{
+    std::lock_guard<std::mutex> lock(i2c->mutex);
+    if (i2cRefused(i2c))
+    {
+        return PICO_ERROR_GENERIC;
+    }
+    i2cTransaction(i2c, src, len);
+    return (int)len;
+}
+
+// Run a triggered DMA transfer into an I2C controller to completion,
+// returning false if the channel does not write to one
+static bool dmaToI2C(HostDMAChannel& ch)
+{
+    i2c_inst_t* i2c = nullptr;
+    for (auto pI2C : {i2c0, i2c1})
+    {
+        if (ch.hw.write_addr == (uintptr_t)&pI2C->hw.data_cmd)
+        {
+            i2c = pI2C;
+        }
+    }
+    if (nullptr == i2c)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(i2c->mutex);
+    static uint8_t aTransaction[HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH * 2];
+    size_t nLen            = 0;
+    const uint16_t* pWords = (const uint16_t*)ch.hw.read_addr;
+    i2c->hw.tx_abrt_source = 0;
+    for (uint32_t n = 0; n < ch.hw.transfer_count; ++n)
+    {
+        if (nLen < sizeof(aTransaction))
+        {
+            aTransaction[nLen++] = pWords[n] & 0xff;
+        }
+        if (pWords[n] & I2C_IC_DATA_CMD_STOP_BITS)
+        {
+            if (i2cRefused(i2c))
+            {
+                // The controller flushes its FIFO, and everything written
+                // to it, until the abort is cleared
+                i2c->hw.tx_abrt_source = I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS;
+                nLen                   = 0;
+                break;
+            }
+            i2cTransaction(i2c, aTransaction, nLen);
+            nLen = 0;
+        }
+    }
+    if (0 != nLen)
+    {
+        i2cTransaction(i2c, aTransaction, nLen); // the controller would hold the bus, decode it anyway
+    }
+    ch.hw.transfer_count = 0;
+    return true;
+}
+
+HostI2CStats host_i2c_stats(i2c_inst_t* pI2C)
+{
+    std::lock_guard<std::mutex> lock(pI2C->mutex);
+    HostI2CStats stats = pI2C->stats;
+    stats.nDataBytes   = pI2C->oled.nDataBytes;
+    return stats;
+}
+
+void host_i2c_reset_stats(i2c_inst_t* pI2C)
+{
+    std::lock_guard<std::mutex> lock(pI2C->mutex);
+    pI2C->stats           = HostI2CStats();
+    pI2C->oled.nDataBytes = 0;
+}
+
+void host_i2c_fail(i2c_inst_t* pI2C, uint nSkip, uint nTransactions)
+{
+    std::lock_guard<std::mutex> lock(pI2C->mutex);
+    pI2C->nSkip = nSkip;
+    pI2C->nFail = nTransactions;
+}
+
+void host_ssd1306_ram(i2c_inst_t* pI2C, uint8_t* pRAM)
+{
+    std::lock_guard<std::mutex> lock(pI2C->mutex);
+    memcpy(pRAM, pI2C->oled.aRAM, sizeof(pI2C->oled.aRAM));
+}
+
+// SPI, decoded as SSD1306 traffic while the attached chip select is low,
+// as commands or data by the level of the attached D/C# pin
+
+struct spi_inst
+{
+    std::mutex mutex;
+    spi_hw_t hw;
+    HostSPIStats stats;
+    HostSSD1306 oled;
+    uint nDCPin;
+    uint nCSPin;
+    bool bAttached;
+};
+
+spi_inst_t host_spi0_inst;
+spi_inst_t host_spi1_inst;
+
+uint spi_init(spi_inst_t* spi, uint baudrate)
+{
+    std::lock_guard<std::mutex> lock(spi->mutex);
+    ssd1306Reset(&spi->oled);
+    return baudrate;
+}
+
+void spi_set_format(spi_inst_t* spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order)
+{
+}
+
+spi_hw_t* spi_get_hw(spi_inst_t* spi)
+{
+    return &spi->hw;
+}
+
+uint spi_get_dreq(spi_inst_t* spi, bool is_tx)
+{
+    return (spi == spi0 ? 16 : 18) + (is_tx ? 0 : 1);
+}
+
+bool spi_is_busy(const spi_inst_t* spi)
+{
+    return false;
+}
+
+static void spiTransfer(spi_inst_t* spi, const uint8_t* src, size_t len)
+{
+    ++spi->stats.nTransfers;
+    spi->stats.nBytes += len;
+    if (!spi->bAttached || gpio_get(spi->nCSPin))
+    {
+        return;
+    }
+    bool bData = gpio_get(spi->nDCPin);
+    for (size_t i = 0; i < len; ++i)
+    {
+        bData ? ssd1306Data(&spi->oled, src[i]) : ssd1306Command(&spi->oled, src[i]);
+    }
+}
+
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len)
+{
+    std::lock_guard<std::mutex> lock(spi->mutex);
+    spiTransfer(spi, src, len);
+    return (int)len;
+}
+
+void host_spi_attach_ssd1306(spi_inst_t* pSPI, uint nDCPin, uint nCSPin)
+{
+    std::lock_guard<std::mutex> lock(pSPI->mutex);
+    pSPI->nDCPin    = nDCPin;
+    pSPI->nCSPin    = nCSPin;
+    pSPI->bAttached = true;
+}
+
+HostSPIStats host_spi_stats(spi_inst_t* pSPI)
+{
+    std::lock_guard<std::mutex> lock(pSPI->mutex);
+    HostSPIStats stats = pSPI->stats;
+    stats.nDataBytes   = pSPI->oled.nDataBytes;
+    return stats;
+}
+
+void host_ssd1306_ram(spi_inst_t* pSPI, uint8_t* pRAM)
+{
+    std::lock_guard<std::mutex> lock(pSPI->mutex);
+    memcpy(pRAM, pSPI->oled.aRAM, sizeof(pSPI->oled.aRAM));
+}
+
+// Run a triggered DMA transfer into an SPI data register to completion,
+// returning false if the channel does not write to one
+static bool dmaToSPI(HostDMAChannel& ch)
+{
+    spi_inst_t* spi = nullptr;
+    for (auto pSPI : {spi0, spi1})
+    {
+        if (ch.hw.write_addr == (uintptr_t)&pSPI->hw.dr)
+        {
+            spi = pSPI;
+        }
+    }
+    if (nullptr == spi)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(spi->mutex);
+    spiTransfer(spi, (const uint8_t*)ch.hw.read_addr, ch.hw.transfer_count);
+    ch.hw.transfer_count = 0;
+    return true;
+}
+
+// Multicore, core1 is a thread and each direction has an eight word FIFO
+
+auto constexpr HOST_FIFO_DEPTH = 8;
+
+struct HostFIFO
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<uint32_t> dq;
+};
+
+static HostFIFO sg_aFIFO[2]; // indexed by receiving core
+static thread_local uint sg_nCore = 0;
+
+void multicore_launch_core1(void (*entry)(void))
+{
+    std::thread(
+        [entry]()
+        {
+            sg_nCore = 1;
+            entry();
+        })
+        .detach();
+}
+
+bool multicore_fifo_wready()
+{
+    HostFIFO& fifo = sg_aFIFO[sg_nCore ^ 1];
+    std::lock_guard<std::mutex> lock(fifo.mutex);
+    return fifo.dq.size() < HOST_FIFO_DEPTH;
+}
+
+bool multicore_fifo_rvalid()
+{
+    HostFIFO& fifo = sg_aFIFO[sg_nCore];
+    std::lock_guard<std::mutex> lock(fifo.mutex);
+    return !fifo.dq.empty();
+}
+
+void multicore_fifo_push_blocking(uint32_t data)
+{
+    HostFIFO& fifo = sg_aFIFO[sg_nCore ^ 1];
+    std::unique_lock<std::mutex> lock(fifo.mutex);
+    fifo.cv.wait(lock, [&fifo] { return fifo.dq.size() < HOST_FIFO_DEPTH; });
+    fifo.dq.push_back(data);
+    fifo.cv.notify_all();
+}
+
+uint32_t multicore_fifo_pop_blocking()
+{
+    HostFIFO& fifo = sg_aFIFO[sg_nCore];
+    std::unique_lock<std::mutex> lock(fifo.mutex);
+    fifo.cv.wait(lock, [&fifo] { return !fifo.dq.empty(); });
+    uint32_t data = fifo.dq.front();
+    fifo.dq.pop_front();
+    fifo.cv.notify_all();
+    return data;
+}
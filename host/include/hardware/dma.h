@@ -0,0 +1,71 @@
+/*
+ * Host HAL shim, hardware/dma.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define NUM_DMA_CHANNELS 12
+
+// UART to memory transfers move whatever the UART source has available
+// each time timers are serviced.  Memory to I2C transfers complete as soon
+// as they are triggered, see hardware/i2c.h.
+enum dma_channel_transfer_size
+{
+    DMA_SIZE_8  = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+typedef struct
+{
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    bool ring_write;
+    uint ring_bits;
+    uint dreq;
+} dma_channel_config;
+
+typedef struct
+{
+    uintptr_t read_addr;
+    uintptr_t write_addr;
+    volatile uint32_t transfer_count;
+    uint32_t ctrl_trig;
+} dma_channel_hw_t;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config* c, bool incr);
+void channel_config_set_write_increment(dma_channel_config* c, bool incr);
+void channel_config_set_ring(dma_channel_config* c, bool write, uint size_bits);
+void channel_config_set_dreq(dma_channel_config* c, uint dreq);
+void dma_channel_configure(uint channel,
+                           const dma_channel_config* config,
+                           volatile void* write_addr,
+                           const volatile void* read_addr,
+                           uint transfer_count,
+                           bool trigger);
+dma_channel_hw_t* dma_channel_hw_addr(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_abort(uint channel);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Host HAL shim, hardware/gpio.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+enum gpio_function
+{
+    GPIO_FUNC_SPI  = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C  = 3,
+    GPIO_FUNC_SIO  = 5,
+};
+
+#define GPIO_OUT 1
+#define GPIO_IN  0
+
+// Pins only hold the level last put, for the SPI display emulation to
+// read chip select and D/C#
+static inline void gpio_init(uint gpio)
+{
+}
+static inline void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+}
+static inline void gpio_set_dir(uint gpio, bool out)
+{
+}
+static inline void gpio_pull_up(uint gpio)
+{
+}
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
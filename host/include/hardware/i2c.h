@@ -0,0 +1,54 @@
+/*
+ * Host HAL shim, hardware/i2c.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Writes are decoded as SSD1306 traffic into a memory framebuffer, see host_hal.h
+typedef struct i2c_inst i2c_inst_t;
+extern i2c_inst_t host_i2c0_inst;
+extern i2c_inst_t host_i2c1_inst;
+#define i2c0        (&host_i2c0_inst)
+#define i2c1        (&host_i2c1_inst)
+#define i2c_default i2c0
+
+// Only what a DMA transfer into IC_DATA_CMD needs is modelled.  Such a
+// transfer completes as soon as it is triggered, each word with STOP set
+// ending a transaction that is decoded like an i2c_write_blocking() call.
+// A transaction refused by host_i2c_fail() sets tx_abrt_source and the rest
+// of the transfer is flushed.  Reading clr_tx_abrt cannot be seen here, so
+// tx_abrt_source is cleared when the next transfer starts instead.
+typedef struct
+{
+    uint32_t enable;
+    uint32_t tar;
+    uint32_t data_cmd;
+    uint32_t status;
+    uint32_t tx_abrt_source;
+    uint32_t clr_tx_abrt;
+} i2c_hw_t;
+
+#define I2C_IC_DATA_CMD_STOP_BITS   0x00000200
+#define I2C_IC_STATUS_ACTIVITY_BITS 0x00000001
+#define I2C_IC_STATUS_TFE_BITS      0x00000004
+
+#define I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS 0x00000001
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
+i2c_hw_t* i2c_get_hw(i2c_inst_t* i2c);
+uint i2c_get_dreq(i2c_inst_t* i2c, bool is_tx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,33 @@
+/*
+ * Host HAL shim, hardware/irq.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Handlers run on the thread that raised the interrupt, for DMA that is
+// whichever triggered the transfer
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define NUM_IRQS  32
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_remove_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
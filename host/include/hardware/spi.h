@@ -0,0 +1,60 @@
+/*
+ * Host HAL shim, hardware/spi.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Writes are decoded as SSD1306 traffic once a display is attached with
+// host_spi_attach_ssd1306(), see host_hal.h.  Only the data register is
+// modelled, as a DMA write address; such transfers complete as soon as they
+// are triggered.
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t host_spi0_inst;
+extern spi_inst_t host_spi1_inst;
+#define spi0        (&host_spi0_inst)
+#define spi1        (&host_spi1_inst)
+#define spi_default spi0
+
+typedef struct
+{
+    uint32_t dr;
+} spi_hw_t;
+
+typedef enum
+{
+    SPI_CPOL_0 = 0,
+    SPI_CPOL_1 = 1,
+} spi_cpol_t;
+
+typedef enum
+{
+    SPI_CPHA_0 = 0,
+    SPI_CPHA_1 = 1,
+} spi_cpha_t;
+
+typedef enum
+{
+    SPI_LSB_FIRST = 0,
+    SPI_MSB_FIRST = 1,
+} spi_order_t;
+
+uint spi_init(spi_inst_t* spi, uint baudrate);
+void spi_set_format(spi_inst_t* spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len);
+spi_hw_t* spi_get_hw(spi_inst_t* spi);
+uint spi_get_dreq(spi_inst_t* spi, bool is_tx);
+bool spi_is_busy(const spi_inst_t* spi);
+
+#ifdef __cplusplus
+}
+#endif
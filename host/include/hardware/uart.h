@@ -0,0 +1,52 @@
+/*
+ * Host HAL shim, hardware/uart.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Received bytes come from a file or pipe attached with host_uart_set_source(),
+// transmitted bytes go to the file attached with host_uart_set_sink(), if any.
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t host_uart0_inst;
+extern uart_inst_t host_uart1_inst;
+#define uart0 (&host_uart0_inst)
+#define uart1 (&host_uart1_inst)
+
+// Only the data register is modelled, as a DMA read address
+typedef struct
+{
+    uint32_t dr;
+} uart_hw_t;
+
+typedef enum
+{
+    UART_PARITY_NONE,
+    UART_PARITY_EVEN,
+    UART_PARITY_ODD,
+} uart_parity_t;
+
+uint uart_init(uart_inst_t* uart, uint baudrate);
+uint uart_set_baudrate(uart_inst_t* uart, uint baudrate);
+void uart_set_format(uart_inst_t* uart, uint data_bits, uint stop_bits, uart_parity_t parity);
+void uart_set_hw_flow(uart_inst_t* uart, bool cts, bool rts);
+void uart_set_fifo_enabled(uart_inst_t* uart, bool enabled);
+void uart_set_irqs_enabled(uart_inst_t* uart, bool rx_has_data, bool tx_needs_data);
+uart_hw_t* uart_get_hw(uart_inst_t* uart);
+uint uart_get_dreq(uart_inst_t* uart, bool is_tx);
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len);
+void uart_puts(uart_inst_t* uart, const char* s);
+void uart_tx_wait_blocking(uart_inst_t* uart);
+
+#ifdef __cplusplus
+}
+#endif
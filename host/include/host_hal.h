@@ -0,0 +1,66 @@
+/*
+ * Host HAL shim controls
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include "hardware/uart.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+
+auto constexpr HOST_UART_CHUNK = 64; // Default bytes delivered per DMA service
+
+// UART receive side.  Each time timers are serviced up to nChunk bytes are
+// read from the source into the DMA ring draining that UART, so a replay
+// does not outrun the sentence queue and nothing is dropped.
+void host_uart_set_source(uart_inst_t* pUART, FILE* pFile, size_t nChunk = HOST_UART_CHUNK);
+// UART transmit side, nullptr discards
+void host_uart_set_sink(uart_inst_t* pUART, FILE* pFile);
+bool host_uart_source_done(uart_inst_t* pUART);
+// Rate the source was "sent" at, 0 for whatever the UART is set to.  While
+// the UART is set to a different rate, bytes arrive scrambled as they would
+// from a mismatched line, for exercising baud rate detection.
+void host_uart_set_line_rate(uart_inst_t* pUART, uint nBaudRate);
+
+// Called from the timer service once every attached source is exhausted and
+// nothing further was delivered, typically to stop the GPS loop.
+void host_set_idle_callback(void (*pCB)(void* pCtx), void* pCtx);
+
+// I2C writes are decoded as SSD1306 command and data streams into the
+// emulated display RAM, 128 columns by 8 pages of vertical bytes.
+auto constexpr HOST_SSD1306_WIDTH = 128;
+auto constexpr HOST_SSD1306_PAGES = 8;
+
+struct HostI2CStats
+{
+    uint32_t nTransactions; // i2c_write_blocking calls and STOP-terminated DMA transfers
+    uint32_t nBytes;        // bytes written, including control bytes
+    uint32_t nDataBytes;    // bytes landing in display RAM
+};
+
+HostI2CStats host_i2c_stats(i2c_inst_t* pI2C);
+void host_i2c_reset_stats(i2c_inst_t* pI2C);
+// Copy of the display RAM, HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH bytes
+void host_ssd1306_ram(i2c_inst_t* pI2C, uint8_t* pRAM);
+// After nSkip more transactions the next nTransactions are not acknowledged:
+// nothing reaches the display and i2c_write_blocking returns PICO_ERROR_GENERIC,
+// or a DMA transfer sets tx_abrt_source and loses the rest of its words
+void host_i2c_fail(i2c_inst_t* pI2C, uint nSkip, uint nTransactions);
+
+// SPI writes are decoded the same way into a display of their own, as
+// commands or data by the level of nDCPin, and only while nCSPin is low.
+struct HostSPIStats
+{
+    uint32_t nTransfers; // spi_write_blocking calls and DMA transfers
+    uint32_t nBytes;     // bytes written, commands and data
+    uint32_t nDataBytes; // bytes landing in display RAM
+};
+
+void host_spi_attach_ssd1306(spi_inst_t* pSPI, uint nDCPin, uint nCSPin);
+HostSPIStats host_spi_stats(spi_inst_t* pSPI);
+void host_ssd1306_ram(spi_inst_t* pSPI, uint8_t* pRAM);
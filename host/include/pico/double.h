@@ -0,0 +1,10 @@
+/*
+ * Host HAL shim, pico/double.h
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <math.h>
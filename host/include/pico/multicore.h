@@ -0,0 +1,26 @@
+/*
+ * Host HAL shim, pico/multicore.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// core1 is a detached thread, the FIFOs are eight words deep as on the RP2040
+void multicore_launch_core1(void (*entry)(void));
+bool multicore_fifo_wready(void);
+bool multicore_fifo_rvalid(void);
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+
+#ifdef __cplusplus
+}
+#endif
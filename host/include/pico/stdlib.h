@@ -0,0 +1,58 @@
+/*
+ * Host HAL shim, pico/stdlib.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef unsigned int uint;
+
+#define PICO_OK            0
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+#define PICO_ERROR_NO_DATA -3
+
+// Time comes from the host monotonic clock
+typedef uint64_t absolute_time_t;
+
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+
+static inline void tight_loop_contents(void)
+{
+}
+
+// Repeating timers do not run on their own.  They fire, after the UART
+// sources have been pumped into any DMA rings, whenever the code would doze
+// in best_effort_wfe_or_timeout(), so replays run as fast as they parse.
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t* rt);
+struct repeating_timer
+{
+    int64_t delay_us;
+    repeating_timer_callback_t callback;
+    void* user_data;
+};
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out);
+bool cancel_repeating_timer(repeating_timer_t* timer);
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+#ifdef __cplusplus
+}
+#endif
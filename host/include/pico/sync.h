@@ -0,0 +1,34 @@
+/*
+ * Host HAL shim, pico/sync.h subset
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include "pico/stdlib.h"
+
+// Critical sections only need to exclude the other "core", which is a thread here
+typedef struct critical_section
+{
+    pthread_mutex_t mutex;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t* crit_sec)
+{
+    pthread_mutex_init(&crit_sec->mutex, NULL);
+}
+static inline void critical_section_deinit(critical_section_t* crit_sec)
+{
+    pthread_mutex_destroy(&crit_sec->mutex);
+}
+static inline void critical_section_enter_blocking(critical_section_t* crit_sec)
+{
+    pthread_mutex_lock(&crit_sec->mutex);
+}
+static inline void critical_section_exit(critical_section_t* crit_sec)
+{
+    pthread_mutex_unlock(&crit_sec->mutex);
+}
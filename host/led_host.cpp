@@ -0,0 +1,15 @@
+/*
+ * Host LED support
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#include "pico/stdlib.h"
+#include "led.h"
+
+// No alarms on the host, the LED is just switched on
+void LED::Blink_ms(uint duration)
+{
+    On();
+}
@@ -0,0 +1,219 @@
+/*
+ * Replay a recorded NMEA log through the GPS and display pipeline on the host
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "host_hal.h"
+#include "gps_oled.h"
+
+// Wiring of the emulated SPI display, any free pins will do
+auto constexpr HOST_SPI_DC_PIN  = 20;
+auto constexpr HOST_SPI_CS_PIN  = 17;
+auto constexpr HOST_SPI_RST_PIN = 21;
+
+static void usage(const char* pszProgram)
+{
+    fprintf(stderr,
+            "usage: %s [-a] [-b baud] [-c chunk] [-d] [-e echo_file] [-p] [-s] <log.nmea | log.ubx | ->\n"
+            "  -a  detect the baud rate as the firmware would at startup\n"
+            "  -b  rate the log was sent at, bytes arrive scrambled while the UART differs (default 9600)\n"
+            "  -c  bytes delivered per DMA service (default %d)\n"
+            "  -d  queue display frames to DMA rather than writing them in Show()\n"
+            "  -e  write the UART1 echo to echo_file\n"
+            "  -p  drive the display over SPI rather than I2C\n"
+            "  -s  print the final display contents\n",
+            pszProgram,
+            HOST_UART_CHUNK);
+}
+
+static void stopGPS(void* pCtx)
+{
+    reinterpret_cast<GPS*>(pCtx)->Stop();
+}
+
+static void printScreen(const uint8_t* pRAM)
+{
+    for (int y = 0; y < HOST_SSD1306_PAGES * 8; ++y)
+    {
+        for (int x = 0; x < HOST_SSD1306_WIDTH; ++x)
+        {
+            putchar((pRAM[(y / 8) * HOST_SSD1306_WIDTH + x] >> (y % 8)) & 1 ? '#' : '.');
+        }
+        putchar('\n');
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t nChunk        = HOST_UART_CHUNK;
+    const char* pszEcho  = nullptr;
+    bool bShowScreen     = false;
+    bool bAutoBaud       = false;
+    bool bAsyncDisplay   = false;
+    bool bSPIDisplay     = false;
+    uint nLineRate       = 9600;
+    int opt;
+    while ((opt = getopt(argc, argv, "ab:c:de:ps")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            bAutoBaud = true;
+            break;
+        case 'b':
+            nLineRate = strtoul(optarg, nullptr, 0);
+            break;
+        case 'c':
+            nChunk = strtoul(optarg, nullptr, 0);
+            break;
+        case 'd':
+            bAsyncDisplay = true;
+            break;
+        case 'e':
+            pszEcho = optarg;
+            break;
+        case 'p':
+            bSPIDisplay = true;
+            break;
+        case 's':
+            bShowScreen = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* pLog = strcmp(argv[optind], "-") ? fopen(argv[optind], "rb") : stdin;
+    if (nullptr == pLog)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    FILE* pEcho = nullptr;
+    if (nullptr != pszEcho && nullptr == (pEcho = fopen(pszEcho, "wb")))
+    {
+        perror(pszEcho);
+        return 1;
+    }
+
+    uart_init(uart0, 9600);
+    uart_init(uart1, 9600);
+    i2c_init(i2c0, 400 * 1000);
+    spi_init(spi0, 10 * 1000 * 1000);
+    host_spi_attach_ssd1306(spi0, HOST_SPI_DC_PIN, HOST_SPI_CS_PIN);
+
+    GPS::Shared spGPS = std::make_shared<GPS>(uart0, pEcho ? uart1 : nullptr);
+    SSD1306::Shared spDisplay;
+    if (bSPIDisplay)
+    {
+        spDisplay = std::make_shared<SSD1306_SPI>(128, 64, spi0, HOST_SPI_DC_PIN, HOST_SPI_CS_PIN, HOST_SPI_RST_PIN);
+    }
+    else
+    {
+        auto spI2CDisplay = std::make_shared<SSD1306_I2C>(128, 64, i2c0);
+        spI2CDisplay->SetAsync(bAsyncDisplay);
+        spDisplay = spI2CDisplay;
+    }
+    GPS_OLED::Shared spDevice = std::make_shared<GPS_OLED>(spDisplay, spGPS, nullptr);
+    spDevice->Initialize();
+
+    host_uart_set_source(uart0, pLog, nChunk);
+    host_uart_set_line_rate(uart0, nLineRate);
+    spGPS->SetAutoBaud(bAutoBaud);
+    host_uart_set_sink(uart1, pEcho);
+    host_set_idle_callback(stopGPS, spGPS.get());
+
+    uint64_t nStart = time_us_64();
+    spDevice->Run();
+    uint64_t nElapsed = time_us_64() - nStart;
+
+    GPSRxStats rxStats    = spGPS->GetRxStats();
+    HostI2CStats i2cStats = host_i2c_stats(i2c0);
+    HostSPIStats spiStats = host_spi_stats(spi0);
+    fprintf(stderr,
+            "%u sentences in %.3f s (%.0f/s)  invalid: %u  dropped: %u (%u bytes)  queue high water: %u\n",
+            rxStats.nSentences,
+            nElapsed / 1e6,
+            nElapsed ? rxStats.nSentences * 1e6 / nElapsed : 0.0,
+            rxStats.nInvalid,
+            rxStats.nDroppedSentences,
+            rxStats.nDroppedBytes,
+            rxStats.nHighWater);
+    if (bAutoBaud)
+    {
+        GPSAutoBaud autoBaud = spGPS->GetAutoBaud();
+        fprintf(stderr,
+                "autobaud: %s %u baud after %u ms, %u rates tried\n",
+                autoBaud.bLocked ? "locked at" : "gave up at",
+                autoBaud.nBaudRate,
+                autoBaud.nTimeToLockMs,
+                autoBaud.nRatesTried);
+    }
+    if (rxStats.nUBXFrames)
+    {
+        fprintf(stderr, "%u UBX frames  queue high water: %u\n", rxStats.nUBXFrames, rxStats.nUBXHighWater);
+    }
+    fprintf(stderr,
+            "I2C: %u transactions  %u bytes  %u display bytes\n",
+            i2cStats.nTransactions,
+            i2cStats.nBytes,
+            i2cStats.nDataBytes);
+    fprintf(stderr,
+            "SPI: %u transfers  %u bytes  %u display bytes\n",
+            spiStats.nTransfers,
+            spiStats.nBytes,
+            spiStats.nDataBytes);
+    if (bShowScreen)
+    {
+        uint8_t aRAM[HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH];
+        if (bSPIDisplay)
+        {
+            host_ssd1306_ram(spi0, aRAM);
+        }
+        else
+        {
+            host_ssd1306_ram(i2c0, aRAM);
+        }
+        printScreen(aRAM);
+    }
+
+    // With GPS_OLED_DUAL_CORE the renderer thread never returns, so leave
+    // without tearing the display objects down underneath it.
+    fflush(stdout);
+    if (nullptr != pEcho)
+    {
+        fclose(pEcho);
+    }
+    _exit(0);
+}
@@ -0,0 +1,147 @@
+/*
+ * NMEA field conversion tests
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "nmea.h"
+
+static uint sg_nChecked  = 0;
+static uint sg_nFailures = 0;
+
+// (D)DDMM.mmmm through strtod() and doubles, in 1e-7 degrees before rounding
+static double referenceDegrees(const char* pszField)
+{
+    double dRaw     = strtod(pszField, nullptr);
+    double dDegrees = floor(dRaw / 100);
+    double dMinutes = dRaw - dDegrees * 100;
+    return (dDegrees + dMinutes / 60) * 1e7;
+}
+
+// The integer result must be the reference rounded to nearest, allowing for
+// the double's own error where the reference sits on a half
+static void checkDegrees(const char* pszField, uint32_t nMaxDegrees = 180)
+{
+    ++sg_nChecked;
+    int32_t nDegrees = 0;
+    double dExpected = referenceDegrees(pszField);
+    if (!nmea_to_degrees(pszField, nDegrees, nMaxDegrees) || fabs(nDegrees - dExpected) > 0.5 + 1e-5)
+    {
+        if (++sg_nFailures <= 10)
+        {
+            printf("FAIL %s: got %d, expected %.3f\n", pszField, nDegrees, dExpected);
+        }
+    }
+}
+
+static void checkRejected(const char* pszField, uint32_t nMaxDegrees = 180)
+{
+    ++sg_nChecked;
+    int32_t nDegrees = 0;
+    if (nmea_to_degrees(pszField, nDegrees, nMaxDegrees))
+    {
+        ++sg_nFailures;
+        printf("FAIL \"%s\": accepted as %d\n", pszField, nDegrees);
+    }
+}
+
+int main()
+{
+    char szField[24];
+
+    // Every ddmm.mmmm value for a few latitudes
+    for (uint nDegrees : {0u, 1u, 45u, 89u})
+    {
+        for (uint nMinutes = 0; nMinutes < 600000; ++nMinutes)
+        {
+            snprintf(szField, sizeof(szField), "%02u%02u.%04u", nDegrees, nMinutes / 10000, nMinutes % 10000);
+            checkDegrees(szField);
+        }
+    }
+
+    // Every whole minute of every latitude and longitude, with a spread of fractions
+    for (uint nDegrees = 0; nDegrees < 180; ++nDegrees)
+    {
+        for (uint nMinutes = 0; nMinutes < 60; ++nMinutes)
+        {
+            for (uint nFraction = nDegrees % 37; nFraction < 10000; nFraction += 37)
+            {
+                if (nDegrees < 100)
+                {
+                    snprintf(szField, sizeof(szField), "%02u%02u.%04u", nDegrees, nMinutes, nFraction);
+                    checkDegrees(szField);
+                }
+                snprintf(szField, sizeof(szField), "%03u%02u.%04u", nDegrees, nMinutes, nFraction);
+                checkDegrees(szField);
+            }
+        }
+    }
+
+    // Higher resolution receivers, from 1 to 7 fraction digits
+    uint32_t nSeed = 1;
+    for (uint i = 0; i < 1000000; ++i)
+    {
+        nSeed          = nSeed * 1664525 + 1013904223;
+        uint nDigits   = 1 + (nSeed >> 8) % 7;
+        uint nFraction = (nSeed >> 4) % 10000000;
+        uint nModulus  = 1;
+        for (uint n = 0; n < nDigits; ++n)
+        {
+            nModulus *= 10;
+        }
+        snprintf(szField, sizeof(szField), "%03u%02u.%0*u", (nSeed >> 24) % 180, (nSeed >> 12) % 60, (int)nDigits, nFraction % nModulus);
+        checkDegrees(szField);
+    }
+
+    // No fraction, and digits past the output resolution
+    checkDegrees("4807");
+    checkDegrees("4807.");
+    checkDegrees("01131.000000001");
+    checkDegrees("17959.99999999");
+
+    // The limits themselves
+    checkDegrees("18000.0000");
+    checkDegrees("18000.00000004");
+    checkDegrees("9000.0000", 90);
+    checkDegrees("08959.9999999", 90);
+
+    checkRejected("");
+    checkRejected("48");
+    checkRejected(".5");
+    checkRejected("4860.0000");
+    checkRejected("48a7.038");
+    checkRejected("4807.03x");
+    checkRejected("-4807.038");
+    checkRejected("180000.000");
+    checkRejected("18000.0001");
+    checkRejected("18100.0000");
+    checkRejected("99959.9999");
+    checkRejected("9000.0001", 90);
+    checkRejected("9100.0000", 90);
+    checkRejected("17959.9999", 90);
+
+    printf("nmea_to_degrees: %u inputs, %u failures\n", sg_nChecked, sg_nFailures);
+    return sg_nFailures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * SSD1306 shadow tests
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_hal.h"
+#include "ssd1306.h"
+
+static uint sg_nChecked  = 0;
+static uint sg_nFailures = 0;
+
+static void check(bool bOK, const char* pszCase, const char* pszWhat)
+{
+    ++sg_nChecked;
+    if (!bOK)
+    {
+        ++sg_nFailures;
+        printf("FAIL %s: %s\n", pszCase, pszWhat);
+    }
+}
+
+// Display RAM matches the framebuffer
+static bool displayed(SSD1306& display)
+{
+    uint8_t aRAM[HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH];
+    host_ssd1306_ram(i2c0, aRAM);
+    return 0 == memcmp(aRAM, display.buffer(), sizeof(aRAM));
+}
+
+// Show() a change of three windows with transactions refused along the way,
+// then check the next Show() repairs the display and the one after is idle
+static void checkFailedShow(SSD1306& display, const char* pszCase, uint nSkip, uint nFail)
+{
+    static uint sl_nFrame = 0;
+    char szText[16];
+    snprintf(szText, sizeof(szText), "%02u:%02u", ++sl_nFrame, nSkip);
+    display.FillRect(8, 8, 112, 48, COLOUR_BLACK);
+    display.Text(szText, 8, 8, COLOUR_WHITE);
+    display.Text(szText, 48, 24, COLOUR_WHITE);
+    display.Text(szText, 80, 40, COLOUR_WHITE);
+    host_i2c_fail(i2c0, nSkip, nFail);
+    display.Show();
+    display.Wait();
+    check(!displayed(display), pszCase, "refused writes reached the display");
+    host_i2c_fail(i2c0, 0, 0); // a DMA transfer is flushed at its first refusal
+
+    display.Show();
+    display.Wait();
+    check(displayed(display), pszCase, "display not repaired by the next Show()");
+    check(HOST_SSD1306_PAGES * HOST_SSD1306_WIDTH == display.GetStats().nLastBytes, pszCase, "repair did not send the whole frame");
+
+    display.Show();
+    display.Wait();
+    check(0 == display.GetStats().nLastBytes, pszCase, "Show() with nothing changed sent data");
+}
+
+static void checkDisplay(SSD1306& display, const char* pszCase)
+{
+    display.Initialize();
+    display.Fill(COLOUR_BLACK);
+    display.Rect(0, 0, 128, 64, COLOUR_WHITE);
+    display.Show();
+    display.Wait();
+    check(displayed(display), pszCase, "first frame not displayed");
+
+    // A refused window drops its data, the data may be refused on its own,
+    // and the rest of the frame still goes
+    checkFailedShow(display, pszCase, 0, 1);
+    checkFailedShow(display, pszCase, 1, 1);
+    checkFailedShow(display, pszCase, 3, 1);
+    checkFailedShow(display, pszCase, 2, 3);
+
+    // A frame that never got through
+    display.Fill(COLOUR_BLACK);
+    display.Ellipse(64, 32, 30, 20, COLOUR_WHITE, true);
+    host_i2c_fail(i2c0, 0, 100);
+    display.Show();
+    display.Wait();
+    host_i2c_fail(i2c0, 0, 0);
+    display.Show();
+    display.Wait();
+    check(displayed(display), pszCase, "display not repaired after a lost frame");
+}
+
+int main()
+{
+    i2c_init(i2c0, 400 * 1000);
+    SSD1306_I2C display(128, 64, i2c0);
+    checkDisplay(display, "blocking");
+
+    // The frame is queued and a refused transaction is only seen as the
+    // controller's TX abort
+    display.SetAsync(true);
+    checkDisplay(display, "DMA");
+
+    printf("ssd1306 shadow: %u checks, %u failures\n", sg_nChecked, sg_nFailures);
+    return sg_nFailures ? 1 : 0;
+}
@@ -0,0 +1,445 @@
+/*
+ * UBX decoder tests over the checked-in capture
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "pico/stdlib.h"
+#include "host_hal.h"
+#include "gps.h"
+
+auto constexpr TEST_EPOCHS = 120; // NAV-PVT, NAV-SAT and GNGGA once a second
+auto constexpr TEST_SVS    = 24;  // GPS, GLONASS and Galileo skies in make_corpus.py
+
+static uint sg_nChecked  = 0;
+static uint sg_nFailures = 0;
+static FILE* sg_pOut     = nullptr; // stdout is silenced while GPS::Run() prints
+
+static void check(bool bOK, const char* pszFormat, ...)
+{
+    ++sg_nChecked;
+    if (!bOK && ++sg_nFailures <= 20)
+    {
+        va_list args;
+        va_start(args, pszFormat);
+        fprintf(sg_pOut, "FAIL ");
+        vfprintf(sg_pOut, pszFormat, args);
+        fprintf(sg_pOut, "\n");
+        va_end(args);
+    }
+}
+
+// The receiver's path in make_corpus.py, evaluated as the script does
+struct Epoch
+{
+    int32_t nLat;
+    int32_t nLon;
+    int32_t nHMSL;
+    int32_t nSpeed;
+    uint32_t nUTCTime;
+
+    explicit Epoch(int t)
+    {
+        double dAlt   = 545.4 + 5 * sin(t / 60.0);
+        double dKnots = 12.0 + 3 * sin(t / 30.0);
+        nLat          = (int32_t)llround((48.1173 + 0.01 * sin(t / 300.0)) * 1e7);
+        nLon          = (int32_t)llround((11.5167 + 0.01 * cos(t / 300.0)) * 1e7);
+        nHMSL         = (int32_t)(dAlt * 1000);
+        nSpeed        = (int32_t)(dKnots * 514.444);
+        nUTCTime      = (12 + t / 3600) % 24 * 10000 + (t / 60) % 60 * 100 + t % 60;
+    }
+};
+
+// Frames in the capture, found the way GPS::drainRx finds them: a frame can
+// only start between NMEA lines
+static std::vector<UBXFrame> scanFrames(const std::string& strLog, uint& nLines, uint& nBad)
+{
+    std::vector<UBXFrame> vFrames;
+    UBXFrame frame;
+    UBXParser parser;
+    bool bInFrame = false;
+    bool bInLine  = false;
+    nLines        = 0;
+    nBad          = 0;
+    for (char ch : strLog)
+    {
+        if (bInFrame || (!bInLine && (uint8_t)ch == UBX_SYNC1))
+        {
+            if (!bInFrame)
+            {
+                parser.Begin(&frame);
+                bInFrame = true;
+            }
+            switch (parser.Feed(ch))
+            {
+            case UBXParser::kFrame:
+                vFrames.push_back(frame);
+                bInFrame = false;
+                break;
+            case UBXParser::kBad:
+            case UBXParser::kOverlength:
+                ++nBad;
+                bInFrame = false;
+                break;
+            default:
+                break;
+            }
+            continue;
+        }
+        bInLine = (ch != '\n');
+        nLines += (ch == '\n');
+    }
+    return vFrames;
+}
+
+static void checkPVT(const UBXFrame& frame, int t)
+{
+    Epoch epoch(t);
+    const uint8_t* p = frame.Payload();
+    check(frame.nClass == UBX_CLASS_NAV && frame.nId == UBX_NAV_PVT, "epoch %d: frame %02x/%02x is not NAV-PVT", t, frame.nClass, frame.nId);
+    check(frame.nPayloadLen == UBX_PVT_LEN, "epoch %d: NAV-PVT length %u", t, frame.nPayloadLen);
+    check(ubx_u32(p) == (uint32_t)t * 1000, "epoch %d: iTOW %u", t, ubx_u32(p));
+    check(p[UBX_PVT_HOUR] * 10000u + p[UBX_PVT_MIN] * 100u + p[UBX_PVT_SEC] == epoch.nUTCTime, "epoch %d: time", t);
+    check(p[UBX_PVT_VALID] == 0x07, "epoch %d: valid %02x", t, p[UBX_PVT_VALID]);
+    check(p[UBX_PVT_FIX_TYPE] == 3 && p[UBX_PVT_FLAGS] == 0x01, "epoch %d: fix type %u flags %02x", t, p[UBX_PVT_FIX_TYPE], p[UBX_PVT_FLAGS]);
+    check(ubx_i32(p + UBX_PVT_LAT) == epoch.nLat, "epoch %d: lat %d, expected %d", t, ubx_i32(p + UBX_PVT_LAT), epoch.nLat);
+    check(ubx_i32(p + UBX_PVT_LON) == epoch.nLon, "epoch %d: lon %d, expected %d", t, ubx_i32(p + UBX_PVT_LON), epoch.nLon);
+    check(ubx_i32(p + UBX_PVT_HMSL) == epoch.nHMSL, "epoch %d: hMSL %d", t, ubx_i32(p + UBX_PVT_HMSL));
+    check(ubx_i32(p + UBX_PVT_GSPEED) == epoch.nSpeed, "epoch %d: gSpeed %d", t, ubx_i32(p + UBX_PVT_GSPEED));
+}
+
+// NAV-SAT, returning the satellites flagged as used
+static uint checkSAT(const UBXFrame& frame, int t)
+{
+    static const uint8_t aGnssIds[] = {0, 6, 2};
+    static const std::vector<uint8_t> aSvIds[] = {
+        {2, 5, 7, 13, 15, 18, 20, 24, 29, 30},
+        {1, 2, 8, 9, 16, 17, 18}, // GLONASS slots, NMEA 65 and up
+        {3, 5, 8, 13, 15, 24, 27},
+    };
+
+    const uint8_t* p = frame.Payload();
+    check(frame.nClass == UBX_CLASS_NAV && frame.nId == UBX_NAV_SAT, "epoch %d: frame %02x/%02x is not NAV-SAT", t, frame.nClass, frame.nId);
+    check(ubx_u32(p) == (uint32_t)t * 1000, "epoch %d: NAV-SAT iTOW %u", t, ubx_u32(p));
+    check(p[UBX_SAT_NUM_SVS] == TEST_SVS, "epoch %d: numSvs %u", t, p[UBX_SAT_NUM_SVS]);
+    check(frame.nPayloadLen == UBX_SAT_BLOCK + TEST_SVS * UBX_SAT_BLOCK_LEN, "epoch %d: NAV-SAT length %u", t, frame.nPayloadLen);
+    if (frame.nPayloadLen != UBX_SAT_BLOCK + TEST_SVS * UBX_SAT_BLOCK_LEN)
+    {
+        return 0;
+    }
+
+    uint nUsed = 0;
+    uint i     = 0;
+    for (uint nSky = 0; nSky < 3; ++nSky)
+    {
+        for (uint8_t nSvId : aSvIds[nSky])
+        {
+            const uint8_t* pSat = p + UBX_SAT_BLOCK + i++ * UBX_SAT_BLOCK_LEN;
+            int8_t nElevation   = (int8_t)pSat[3];
+            int16_t nAzimuth    = (int16_t)ubx_u16(pSat + 4);
+            uint8_t nCNo        = pSat[2];
+            check(pSat[0] == aGnssIds[nSky] && pSat[1] == nSvId, "epoch %d: block %u is %u/%u", t, i, pSat[0], pSat[1]);
+            check(nElevation >= 5 && nElevation <= 85 && nAzimuth >= 0 && nAzimuth < 360 && nCNo <= 55,
+                  "epoch %d: block %u elevation %d azimuth %d C/N0 %u",
+                  t,
+                  i,
+                  nElevation,
+                  nAzimuth,
+                  nCNo);
+            check((pSat[8] & 0x07) == (nCNo > 0 ? 0x07 : 0x01), "epoch %d: block %u flags %02x", t, i, pSat[8]);
+            nUsed += (pSat[8] & UBX_SAT_USED) != 0;
+        }
+    }
+    return nUsed;
+}
+
+// Fed whole, a frame with any byte after the length changed must not decode
+static void checkChecksum(const UBXFrame& frame)
+{
+    UBXFrame target;
+    UBXParser parser;
+    auto feed = [&](const uint8_t* pData, size_t nLen) {
+        UBXParser::eResult eResult = UBXParser::kPending;
+        parser.Begin(&target);
+        for (size_t i = 0; i < nLen && eResult == UBXParser::kPending; ++i)
+        {
+            eResult = parser.Feed(pData[i]);
+        }
+        return eResult;
+    };
+
+    check(feed(frame.aData, frame.nLen) == UBXParser::kFrame, "intact frame rejected");
+    check(target.nLen == frame.nLen && std::equal(frame.aData, frame.aData + frame.nLen, target.aData), "intact frame altered");
+
+    uint8_t aData[UBX_MAX_FRAME];
+    for (uint i = 2; i < frame.nLen; ++i)
+    {
+        if (i == 4 || i == 5)
+        {
+            continue; // a different length leaves the parser waiting for more
+        }
+        for (uint8_t nFlip : {0x01, 0x80})
+        {
+            std::copy(frame.aData, frame.aData + frame.nLen, aData);
+            aData[i] ^= nFlip;
+            check(feed(aData, frame.nLen) == UBXParser::kBad, "byte %u ^ %02x accepted", i, nFlip);
+        }
+    }
+
+    // Bad sync, and a length beyond UBX_MAX_PAYLOAD
+    static const uint8_t aBadSync[]   = {UBX_SYNC1, 'x'};
+    static const uint8_t aOversized[] = {UBX_SYNC1, UBX_SYNC2, UBX_CLASS_NAV, UBX_NAV_SAT, 0x01, 0x10};
+    check(feed(aBadSync, sizeof(aBadSync)) == UBXParser::kBad, "bad sync accepted");
+    check(feed(aOversized, sizeof(aOversized)) == UBXParser::kOverlength, "oversized frame accepted");
+}
+
+static void stopGPS(void* pCtx)
+{
+    reinterpret_cast<GPS*>(pCtx)->Stop();
+}
+
+static void saveGPSData(void* pCtx, const GPSData& gpsData)
+{
+    *reinterpret_cast<GPSData*>(pCtx) = gpsData;
+}
+
+// Every frame through GPS::Run(), with junk and stray sync bytes ahead of
+// some of them and a corrupted copy of the last NAV-PVT after it, which
+// must all be skipped
+static void checkPipeline(const std::vector<UBXFrame>& vFrames)
+{
+    std::string strStream;
+    uint nJunk = 0;
+    for (size_t i = 0; i < vFrames.size(); ++i)
+    {
+        if (i % 10 == 5)
+        {
+            strStream += (i % 20 == 5) ? std::string("\xb5\x00", 2) : std::string("\x07 junk \xb5x ", 10);
+            ++nJunk;
+        }
+        strStream.append((const char*)vFrames[i].aData, vFrames[i].nLen);
+    }
+    UBXFrame corrupt = vFrames[vFrames.size() - 2];
+    corrupt.aData[UBX_HEADER_LEN + UBX_PVT_LAT] ^= 0x10;
+    strStream.append((const char*)corrupt.aData, corrupt.nLen);
+    ++nJunk;
+
+    GPSData gpsData;
+    FILE* pStream  = fmemopen(const_cast<char*>(strStream.data()), strStream.size(), "rb");
+    GPS::Shared spGPS = std::make_shared<GPS>(uart0);
+    spGPS->SetGpsDataCallback(&gpsData, saveGPSData);
+    host_uart_set_source(uart0, pStream);
+    host_set_idle_callback(stopGPS, spGPS.get());
+    spGPS->Run();
+    host_set_idle_callback(nullptr, nullptr);
+    host_uart_set_source(uart0, nullptr);
+    fclose(pStream);
+
+    GPSRxStats rxStats = spGPS->GetRxStats();
+    check(rxStats.nUBXFrames == vFrames.size(), "pipeline: %u of %zu frames", rxStats.nUBXFrames, vFrames.size());
+    check(rxStats.nInvalid >= nJunk, "pipeline: %u invalid for %u bad runs", rxStats.nInvalid, nJunk);
+    check(rxStats.nDroppedSentences == 0, "pipeline: %u dropped", rxStats.nDroppedSentences);
+
+    // The last snapshot, as GPS::processUBX() decoded it.  NAV-SAT does not
+    // publish on its own, like GSV, so the sky view is the previous epoch's.
+    const UBXFrame& pvt = vFrames[vFrames.size() - 2];
+    const UBXFrame& sat = vFrames[vFrames.size() - 3];
+    Epoch epoch(TEST_EPOCHS - 1);
+    check(gpsData.bHasPosition && gpsData.bHasLatLon && gpsData.nFixMode == 3, "pipeline: no 3D fix");
+    check(gpsData.nLatitude == epoch.nLat && gpsData.nLongitude == epoch.nLon,
+          "pipeline: position %d %d, expected %d %d",
+          gpsData.nLatitude,
+          gpsData.nLongitude,
+          epoch.nLat,
+          epoch.nLon);
+    check(gpsData.nAltitude == epoch.nHMSL, "pipeline: altitude %d", gpsData.nAltitude);
+    check(gpsData.nSpeed == (uint32_t)epoch.nSpeed / 10, "pipeline: speed %u", gpsData.nSpeed);
+    check(gpsData.bHasTime && gpsData.nUTCTime == epoch.nUTCTime, "pipeline: time %u", gpsData.nUTCTime);
+    check(gpsData.nNumSats == pvt.Payload()[UBX_PVT_NUM_SV], "pipeline: %d satellites", gpsData.nNumSats);
+
+    std::vector<SatInfo> vExpected;
+    for (uint i = 0; i < TEST_SVS; ++i)
+    {
+        const uint8_t* pSat = sat.Payload() + UBX_SAT_BLOCK + i * UBX_SAT_BLOCK_LEN;
+        vExpected.push_back(SatInfo(pSat[1], pSat[3], ubx_u16(pSat + 4), pSat[2], ubx_gnss_system(pSat[0])));
+        check(gpsData.IsUsed(vExpected.back()) == ((pSat[8] & UBX_SAT_USED) != 0), "pipeline: satellite %u/%u used", pSat[0], pSat[1]);
+    }
+    std::sort(vExpected.begin(), vExpected.end(), [](const SatInfo& a, const SatInfo& b) {
+        return a.Key() < b.Key();
+    });
+    check(gpsData.mSatList.size() == vExpected.size(), "pipeline: %zu satellites in view", gpsData.mSatList.size());
+    for (size_t i = 0; i < std::min(gpsData.mSatList.size(), vExpected.size()); ++i)
+    {
+        const SatInfo& oSat = gpsData.mSatList.begin()[i];
+        check(oSat.Key() == vExpected[i].Key() && oSat.m_el == vExpected[i].m_el && oSat.m_az == vExpected[i].m_az &&
+                  oSat.m_rssi == vExpected[i].m_rssi,
+              "pipeline: satellite %zu is %u/%u",
+              i,
+              oSat.m_sys,
+              oSat.m_num);
+    }
+}
+
+// An ACK-ACK or ACK-NAK for CFG message nCfgId, as the parser delivers it
+static UBXFrame ackFrame(uint8_t nAck, uint8_t nCfgId)
+{
+    uint8_t aPayload[2] = {UBX_CLASS_CFG, nCfgId};
+    uint8_t aData[16];
+    size_t nLen = ubx_build(aData, sizeof(aData), UBX_CLASS_ACK, nAck, aPayload, sizeof(aPayload));
+    UBXFrame frame;
+    UBXParser parser;
+    parser.Begin(&frame);
+    for (size_t i = 0; i < nLen; ++i)
+    {
+        parser.Feed(aData[i]);
+    }
+    return frame;
+}
+
+// CFG frames with ID nCfgId in what UBXConfig sent
+static uint countSent(const std::string& strSent, uint8_t nCfgId)
+{
+    const char aHeader[] = {(char)UBX_SYNC1, (char)UBX_SYNC2, (char)UBX_CLASS_CFG, (char)nCfgId};
+    uint nCount = 0;
+    for (size_t nPos = strSent.find(aHeader, 0, 4); nPos != std::string::npos; nPos = strSent.find(aHeader, nPos + 4, 4))
+    {
+        ++nCount;
+    }
+    return nCount;
+}
+
+// UBXConfig against a module that ACKs everything and follows the baud
+// change, one that stays silent, and one that refuses the rate.  nNak is
+// the CFG message to answer with ACK-NAK, or 0xff for none.
+static void checkConfig(const char* pszName, bool bAnswer, uint8_t nNak, uint8_t nExpectResult, uint32_t nExpectBaud)
+{
+    char* pSent    = nullptr;
+    size_t nSent   = 0;
+    FILE* pSink    = open_memstream(&pSent, &nSent);
+    UBXConfig config;
+    UBXSettings settings = {115200, 200};
+    uint64_t nNow        = 0;
+    uart_init(uart0, 9600);
+    host_uart_set_sink(uart0, pSink);
+    config.Start(uart0, settings, 9600);
+    for (uint nStep = 0; config.Busy() && nStep < 2000; ++nStep, nNow += 10000)
+    {
+        size_t nBefore = nSent;
+        config.Step(nNow);
+        fflush(pSink);
+        if (!bAnswer)
+        {
+            continue;
+        }
+        // Answer each frame as it goes out, and once the port has switched
+        // any clean frame at the new rate confirms it
+        uint8_t nCfgId = config.State() == UBXConfig::kRate ? UBX_CFG_RATE : UBX_CFG_MSG;
+        if (config.State() == UBXConfig::kPort)
+        {
+            config.OnFrame(ackFrame(UBX_ACK_ACK, UBX_CFG_PRT), nNow);
+        }
+        else if (nSent > nBefore)
+        {
+            config.OnFrame(ackFrame(nCfgId == nNak ? UBX_ACK_NAK : UBX_ACK_ACK, nCfgId), nNow);
+        }
+    }
+    host_uart_set_sink(uart0, nullptr);
+    fclose(pSink);
+    std::string strSent(pSent, nSent);
+    free(pSent);
+
+    uint nTries = bAnswer ? 1 : UBX_ACK_ATTEMPTS;
+    check(config.State() == UBXConfig::kDone, "config %s: stuck in state %u", pszName, config.State());
+    check(config.Result() == nExpectResult, "config %s: result %x, expected %x", pszName, config.Result(), nExpectResult);
+    check(config.BaudRate() == nExpectBaud, "config %s: %u baud", pszName, config.BaudRate());
+    check(countSent(strSent, UBX_CFG_MSG) == 2 * nTries, "config %s: %u CFG-MSG", pszName, countSent(strSent, UBX_CFG_MSG));
+    check(countSent(strSent, UBX_CFG_RATE) == nTries, "config %s: %u CFG-RATE", pszName, countSent(strSent, UBX_CFG_RATE));
+    // A port change that is not heard from is asked back
+    check(countSent(strSent, UBX_CFG_PRT) == (bAnswer ? 1u : 2u), "config %s: %u CFG-PRT", pszName, countSent(strSent, UBX_CFG_PRT));
+}
+
+int main()
+{
+    // The GPS code prints every sentence, keep that out of the results
+    sg_pOut = fdopen(dup(STDOUT_FILENO), "w");
+    freopen("/dev/null", "w", stdout);
+
+    const char* pszPath = GPS_OLED_CORPUS_DIR "/ubx_1hz.ubx";
+    FILE* pFile         = fopen(pszPath, "rb");
+    if (nullptr == pFile)
+    {
+        perror(pszPath);
+        return 1;
+    }
+    std::string strLog;
+    char aBuf[4096];
+    size_t nRead;
+    while ((nRead = fread(aBuf, 1, sizeof(aBuf), pFile)) > 0)
+    {
+        strLog.append(aBuf, nRead);
+    }
+    fclose(pFile);
+
+    uint nLines = 0;
+    uint nBad   = 0;
+    std::vector<UBXFrame> vFrames = scanFrames(strLog, nLines, nBad);
+    check(vFrames.size() == 2 * TEST_EPOCHS && nLines == TEST_EPOCHS && nBad == 0,
+          "capture: %zu frames, %u NMEA lines, %u bad",
+          vFrames.size(),
+          nLines,
+          nBad);
+    if (vFrames.size() != 2 * TEST_EPOCHS)
+    {
+        fprintf(sg_pOut, "ubx: %u checks, %u failures\n", sg_nChecked, sg_nFailures);
+        return 1;
+    }
+
+    for (int t = 0; t < TEST_EPOCHS; ++t)
+    {
+        checkPVT(vFrames[2 * t], t);
+        uint nUsed = checkSAT(vFrames[2 * t + 1], t);
+        check(nUsed == vFrames[2 * t].Payload()[UBX_PVT_NUM_SV], "epoch %d: %u used, NAV-PVT numSV %u", t, nUsed, vFrames[2 * t].Payload()[UBX_PVT_NUM_SV]);
+    }
+
+    checkChecksum(vFrames[0]);
+    checkChecksum(vFrames[1]);
+
+    uart_init(uart0, 9600);
+    checkPipeline(vFrames);
+
+    using C = UBXConfig;
+    checkConfig("acked", true, 0xff, C::kPVTOK | C::kSATOK | C::kRateOK | C::kPortOK, 115200);
+    checkConfig("silent", false, 0xff, 0, 9600);
+    checkConfig("rate refused", true, UBX_CFG_RATE, C::kPVTOK | C::kSATOK | C::kPortOK, 115200);
+    uart_init(uart0, 9600);
+
+    fprintf(sg_pOut, "ubx: %u checks, %u failures\n", sg_nChecked, sg_nFailures);
+    fclose(sg_pOut);
+    return sg_nFailures ? 1 : 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Integer-only number formatting
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "fixed_format.h"
+
+static uint32_t pow10u(uint n)
+{
+    uint32_t nResult = 1;
+    while (n--)
+    {
+        nResult *= 10;
+    }
+    return nResult;
+}
+
+size_t format_fixed(char* pszOut, size_t nLen, int32_t nValue, uint nScaleDigits, uint nDecimals, uint nWidth)
+{
+    if (0 == nLen)
+    {
+        return 0;
+    }
+
+    bool bNegative = nValue < 0;
+    uint32_t nAbs  = bNegative ? 0u - (uint32_t)nValue : (uint32_t)nValue;
+    if (nDecimals < nScaleDigits)
+    {
+        uint32_t nDivisor = pow10u(nScaleDigits - nDecimals);
+        nAbs              = nAbs / nDivisor + (nAbs % nDivisor >= nDivisor / 2);
+    }
+    else
+    {
+        nDecimals = nScaleDigits;
+    }
+
+    // Build the digits backwards
+    char szTemp[16];
+    size_t n = 0;
+    for (uint i = 0; i < nDecimals; ++i)
+    {
+        szTemp[n++] = '0' + nAbs % 10;
+        nAbs /= 10;
+    }
+    if (nDecimals > 0)
+    {
+        szTemp[n++] = '.';
+    }
+    do
+    {
+        szTemp[n++] = '0' + nAbs % 10;
+        nAbs /= 10;
+    } while (nAbs);
+    if (bNegative)
+    {
+        szTemp[n++] = '-';
+    }
+
+    size_t nOut = 0;
+    for (size_t nPad = n; nPad < nWidth && nOut + 1 < nLen; ++nPad)
+    {
+        pszOut[nOut++] = ' ';
+    }
+    while (n && nOut + 1 < nLen)
+    {
+        pszOut[nOut++] = szTemp[--n];
+    }
+    pszOut[nOut] = '\0';
+    return nOut;
+}
@@ -0,0 +1,16 @@
+/*
+ * Integer-only number formatting
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <pico/stdlib.h>
+
+// Format nValue, which carries nScaleDigits implied decimal places (e.g.
+// millimetres are metres with 3), as text with nDecimals places, rounding
+// half away from zero.  The result is right-aligned in nWidth characters and
+// always NUL terminated; the number of characters written is returned.
+size_t format_fixed(char* pszOut, size_t nLen, int32_t nValue, uint nScaleDigits, uint nDecimals, uint nWidth = 0);
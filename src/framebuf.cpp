@@ -28,6 +28,7 @@
  * THE SOFTWARE.
  */
 
+#include <string.h>
 #include <algorithm>
 #include <iostream>
 
@@ -39,20 +40,97 @@ using std::max;
 using std::min;
 using std::size_t;
 
+// Index of the first byte, stepping from i, at which two words differ,
+// whatever the byte order
+static int changed_byte(uint32_t nOld, uint32_t nNew, int i, int step)
+{
+    const uint8_t* pOld = reinterpret_cast<const uint8_t*>(&nOld);
+    const uint8_t* pNew = reinterpret_cast<const uint8_t*>(&nNew);
+    while (pOld[i] == pNew[i])
+    {
+        i += step;
+    }
+    return i;
+}
+
+// Set the rows in mask to set across w column bytes of one MVLSB page, four
+// columns per load and store once b is word aligned, and return the first
+// and last columns that changed in nMin and nMax (nMax < 0 if none did).
+// A full page makes this a compare-and-store of the set value, a partial one
+// touches each column byte once however many rows the mask covers.
+static void fill_page(uint8_t* b, int w, uint8_t mask, uint8_t set, int& nMin, int& nMax)
+{
+    nMin   = w;
+    nMax   = -1;
+    int xx = 0;
+
+    auto fillByte = [&](int x) {
+        uint8_t n = (b[x] & ~mask) | set;
+        if (n != b[x])
+        {
+            b[x] = n;
+            nMin = min(nMin, x);
+            nMax = x;
+        }
+    };
+    for (; xx < w && (reinterpret_cast<uintptr_t>(b + xx) & 3); ++xx)
+    {
+        fillByte(xx);
+    }
+    uint32_t mask4    = mask * 0x01010101u;
+    uint32_t set4     = set * 0x01010101u;
+    int xLast         = -1; // last word that changed, narrowed to bytes afterwards
+    uint32_t nLastOld = 0;
+    uint32_t nLastNew = 0;
+    for (; xx + 4 <= w; xx += 4)
+    {
+        uint8_t* p = static_cast<uint8_t*>(__builtin_assume_aligned(b + xx, 4));
+        uint32_t nOld;
+        memcpy(&nOld, p, 4);
+        uint32_t nNew = (nOld & ~mask4) | set4;
+        if (nNew == nOld)
+        {
+            continue;
+        }
+        memcpy(p, &nNew, 4);
+        if (nMin > xx)
+        {
+            nMin = xx + changed_byte(nOld, nNew, 0, 1);
+        }
+        xLast    = xx;
+        nLastOld = nOld;
+        nLastNew = nNew;
+    }
+    if (xLast >= 0)
+    {
+        nMax = xLast + changed_byte(nLastOld, nLastNew, 3, -1);
+    }
+    for (; xx < w; ++xx)
+    {
+        fillByte(xx);
+    }
+}
+
 Framebuf::Framebuf()
     : m_pBuf(nullptr),
+      m_pAlloc(nullptr),
       m_nWidth(0),
       m_nHeight(0),
       m_nStride(0),
       m_eFormat(RGB565),
       m_bRevBytes(false),
-      m_pFont(nullptr)
+      m_pFont(nullptr),
+      m_nBands(0),
+      m_pDirtyMin(nullptr),
+      m_pDirtyMax(nullptr)
 {
 }
 
 Framebuf::~Framebuf()
 {
-    if (nullptr == m_pBuf)
+    delete[] m_pDirtyMin;
+    delete[] m_pDirtyMax;
+    if (nullptr == m_pAlloc)
     {
         return;
     }
@@ -61,17 +139,17 @@ Framebuf::~Framebuf()
     case MVLSB:
     case MHLSB:
     case MHMSB:
-        delete[] (uint8_t*)m_pBuf;
+        delete[] (uint8_t*)m_pAlloc;
         break;
     case RGB565:
-        delete[] (uint16_t*)m_pBuf;
+        delete[] (uint16_t*)m_pAlloc;
         break;
     default:
         break;
     }
 }
 
-void Framebuf::Initialize(uint16_t nWidth, uint16_t nHeight, ePixelFormat eFormat, bool bRevBytes, uint16_t nStride)
+void Framebuf::Initialize(uint16_t nWidth, uint16_t nHeight, ePixelFormat eFormat, bool bRevBytes, uint16_t nStride, uint16_t nHeadroom)
 {
     m_nWidth    = nWidth;
     m_nHeight   = nHeight;
@@ -86,135 +164,281 @@ void Framebuf::Initialize(uint16_t nWidth, uint16_t nHeight, ePixelFormat eForma
     case MVLSB:
     case MHLSB:
     case MHMSB:
-        m_pBuf    = new uint8_t[m_nWidth * m_nHeight / 8];
+        m_pAlloc  = new uint8_t[nHeadroom + m_nWidth * m_nHeight / 8];
+        m_pBuf    = (uint8_t*)m_pAlloc + nHeadroom;
         m_nStride = (m_nStride + 7) & ~7;
         break;
     case RGB565:
-        m_pBuf = new uint16_t[m_nWidth * m_nHeight];
+        m_pAlloc = new uint16_t[(nHeadroom + 1) / 2 + m_nWidth * m_nHeight];
+        m_pBuf   = (uint16_t*)m_pAlloc + (nHeadroom + 1) / 2;
         break;
     default:
-        m_pBuf = nullptr;
+        m_pAlloc = nullptr;
+        m_pBuf   = nullptr;
         break;
     }
+
+    // Nothing is known about what the display holds, so all of it is dirty
+    m_nBands    = (m_nHeight + 7) / 8;
+    m_pDirtyMin = new uint16_t[m_nBands];
+    m_pDirtyMax = new uint16_t[m_nBands];
+    clear_dirty();
+    mark_dirty(0, 0, m_nWidth, m_nHeight);
+}
+
+void Framebuf::mark_dirty(int x, int y, int w, int h)
+{
+    if (!check(x, y, w, h) || nullptr == m_pDirtyMin)
+    {
+        return;
+    }
+    for (int nBand = y >> 3; nBand <= (y + h - 1) >> 3; ++nBand)
+    {
+        dirty_span(nBand, x, x + w - 1);
+    }
+}
+
+void Framebuf::clear_dirty()
+{
+    for (uint nBand = 0; nBand < m_nBands; ++nBand)
+    {
+        m_pDirtyMin[nBand] = 0xffff;
+        m_pDirtyMax[nBand] = 0;
+    }
 }
 
 void Framebuf::setpixel(int x, int y, uint16_t color)
 {
-    if (!check(x, y) || nullptr == m_pBuf)
+    if (!check(x, y))
     {
         return;
     }
+    dispatch([&](auto fmt) {
+        plot<decltype(fmt)>(x, y, fmt.encode(color, m_bRevBytes));
+    });
+}
 
-    switch (m_eFormat)
+uint16_t Framebuf::getpixel(int x, int y)
+{
+    uint16_t color = 0;
+    if (check(x, y))
     {
-    case MVLSB:
+        dispatch([&](auto fmt) {
+            color = fmt.get(m_pBuf, m_nStride, x, y);
+        });
+    }
+    return color;
+}
+
+void Framebuf::fillrect(int x, int y, int w, int h, uint16_t color)
+{
+    dispatch([&](auto fmt) {
+        fillrect_t<decltype(fmt)>(x, y, w, h, fmt.encode(color, m_bRevBytes));
+    });
+}
+
+void Framebuf::fill(uint16_t color)
+{
+    fillrect(0, 0, m_nWidth, m_nHeight, color);
+}
+
+void Framebuf::hline(int x, int y, int w, uint16_t color)
+{
+    fillrect(x, y, w, 1, color);
+}
+
+void Framebuf::vline(int x, int y, int h, uint16_t color)
+{
+    fillrect(x, y, 1, h, color);
+}
+
+void Framebuf::rect(int x, int y, int w, int h, uint16_t color, bool bFill)
+{
+    if (bFill)
     {
-        size_t index              = (y >> 3) * m_nStride + x;
-        uint8_t offset            = y & 0x07;
-        ((uint8_t*)m_pBuf)[index] = (((uint8_t*)m_pBuf)[index] & ~(0x01 << offset)) | ((color != 0) << offset);
+        fillrect(x, y, w, h, color);
     }
-    break;
-    case RGB565:
+    else
     {
-        ((uint16_t*)m_pBuf)[x + y * m_nStride] = fixcolor(color);
+        dispatch([&](auto fmt) {
+            using Fmt  = decltype(fmt);
+            uint16_t c = fmt.encode(color, m_bRevBytes);
+            fillrect_t<Fmt>(x, y, w, 1, c);
+            fillrect_t<Fmt>(x, y + h - 1, w, 1, c);
+            fillrect_t<Fmt>(x, y, 1, h, c);
+            fillrect_t<Fmt>(x + w - 1, y, 1, h, c);
+        });
     }
-    break;
-    default:
-        return;
-        break;
+}
+
+void Framebuf::line(int x1, int y1, int x2, int y2, uint16_t color)
+{
+    dispatch([&](auto fmt) {
+        line_t<decltype(fmt)>(x1, y1, x2, y2, fmt.encode(color, m_bRevBytes));
+    });
+}
+
+void Framebuf::ellipse(int cx, int cy, int xradius, int yradius, uint16_t color, bool bFill, uint8_t mask)
+{
+    if (bFill)
+    {
+        mask |= ELLIPSE_MASK_FILL;
     }
+    dispatch([&](auto fmt) {
+        ellipse_t<decltype(fmt)>(cx, cy, xradius, yradius, fmt.encode(color, m_bRevBytes), mask);
+    });
 }
 
-uint16_t Framebuf::getpixel(int x, int y)
+void Framebuf::text(const char* str, int x, int y, uint16_t color)
+{
+    text(str, x, y, color, 1);
+}
+
+void Framebuf::text(const char* str, int x, int y, uint16_t color, int scale)
+{
+    scale = max(scale, 1);
+
+    // If a default font is set, use it
+    if (m_pFont)
+    {
+        return text(str, x, y, color, *m_pFont, scale);
+    }
+    dispatch([&](auto fmt) {
+        text_t<decltype(fmt)>(str, x, y, fmt.encode(color, m_bRevBytes), scale);
+    });
+}
+
+void Framebuf::text(const char* str, int x, int y, uint16_t color, const BitmapFont& font, int scale)
+{
+    scale = max(scale, 1);
+    dispatch([&](auto fmt) {
+        text_t<decltype(fmt)>(str, x, y, fmt.encode(color, m_bRevBytes), font, scale);
+    });
+}
+
+// Private methods
+
+bool Framebuf::check(int& x, int& y)
+{
+    return (0 <= x && x < m_nWidth && 0 <= y && y < m_nHeight);
+}
+
+bool Framebuf::check(int& x, int& y, int& w, int& h)
+{
+    if (w < 1 || h < 1 || x + w <= 0 || y + h <= 0 || x >= m_nWidth || y >= m_nHeight)
+    {
+        return false;
+    }
+    // clip to the framebuffer size
+    int xend = min((int)m_nWidth, x + w);
+    int yend = min((int)m_nHeight, y + h);
+    x        = max(x, 0);
+    y        = max(y, 0);
+    w        = xend - x;
+    h        = yend - y;
+    return true;
+}
+
+template <typename Kernel>
+void Framebuf::dispatch(Kernel&& kernel)
 {
-    if (!check(x, y) || nullptr == m_pBuf)
+    if (nullptr == m_pBuf)
     {
-        return 0;
+        return;
     }
     switch (m_eFormat)
     {
     case MVLSB:
-        return (((uint8_t*)m_pBuf)[(y >> 3) * m_nStride + x] >> (y & 0x07)) & 0x01;
+        kernel(PixelFormat<MVLSB>());
         break;
     case RGB565:
-        return ((uint16_t*)m_pBuf)[x + y * m_nStride];
+        kernel(PixelFormat<RGB565>());
+        break;
+    case MHLSB:
+        kernel(PixelFormat<MHLSB>());
+        break;
+    case MHMSB:
+        kernel(PixelFormat<MHMSB>());
         break;
     default:
-        return 0;
         break;
     }
 }
 
-void Framebuf::fillrect(int x, int y, int w, int h, uint16_t color)
+// Format kernels
+
+template <typename Fmt>
+void Framebuf::plot(int x, int y, uint16_t color)
+{
+    if (Fmt::set(m_pBuf, m_nStride, x, y, color))
+    {
+        dirty_span(y >> 3, x, x);
+    }
+}
+
+template <typename Fmt>
+void Framebuf::fillrect_t(int x, int y, int w, int h, uint16_t color)
 {
-    if (!check(x, y, w, h) || nullptr == m_pBuf)
+    if (!check(x, y, w, h))
     {
         return;
     }
-    switch (m_eFormat)
+    if constexpr (MVLSB == Fmt::eFormat)
     {
-    case MVLSB:
-        while (h--)
+        // A page at a time, so each byte is read and written once and only
+        // the columns that change are marked
+        for (int yend = y + h; y < yend; y = (y | 0x07) + 1)
         {
-            uint8_t* b     = &((uint8_t*)m_pBuf)[(y >> 3) * m_nStride + x];
-            uint8_t offset = y & 0x07;
-            for (unsigned int ww = w; ww; --ww)
+            int ylast    = min(yend, (y | 0x07) + 1) - 1; // last row in this page
+            uint8_t mask = (0xff << (y & 0x07)) & (0xff >> (7 - (ylast & 0x07)));
+            uint8_t set  = color ? mask : 0;
+            uint8_t* b   = &((uint8_t*)m_pBuf)[(y >> 3) * m_nStride + x];
+            if (1 == w)
+            {
+                // vline, every row of the page in one byte write
+                uint8_t n = (*b & ~mask) | set;
+                if (n != *b)
+                {
+                    *b = n;
+                    dirty_span(y >> 3, x, x);
+                }
+                continue;
+            }
+            int nDirtyMin, nDirtyMax;
+            fill_page(b, w, mask, set, nDirtyMin, nDirtyMax);
+            if (nDirtyMax >= 0)
             {
-                *b = (*b & ~(0x01 << offset)) | ((color != 0) << offset);
-                ++b;
+                dirty_span(y >> 3, x + nDirtyMin, x + nDirtyMax);
             }
-            ++y;
         }
-        break;
-    case RGB565:
+    }
+    else if constexpr (RGB565 == Fmt::eFormat)
     {
         uint16_t* b = &((uint16_t*)m_pBuf)[x + y * m_nStride];
-        while (h--)
+        for (int yy = y; yy < y + h; ++yy)
         {
             for (unsigned int ww = w; ww; --ww)
             {
-                *b++ = fixcolor(color);
+                *b++ = color;
             }
             b += m_nStride - w;
+            dirty_span(yy >> 3, x, x + w - 1);
         }
     }
-    break;
-    default:
-        break;
-    }
-}
-
-void Framebuf::fill(uint16_t color)
-{
-    fillrect(0, 0, m_nWidth, m_nHeight, color);
-}
-
-void Framebuf::hline(int x, int y, int w, uint16_t color)
-{
-    fillrect(x, y, w, 1, color);
-}
-
-void Framebuf::vline(int x, int y, int h, uint16_t color)
-{
-    fillrect(x, y, 1, h, color);
-}
-
-void Framebuf::rect(int x, int y, int w, int h, uint16_t color, bool bFill)
-{
-    if (bFill)
-    {
-        fillrect(x, y, w, h, color);
-    }
     else
     {
-        fillrect(x, y, w, 1, color);
-        fillrect(x, y + h - 1, w, 1, color);
-        fillrect(x, y, 1, h, color);
-        fillrect(x + w - 1, y, 1, h, color);
+        for (int yy = y; yy < y + h; ++yy)
+        {
+            for (int xx = x; xx < x + w; ++xx)
+            {
+                plot<Fmt>(xx, yy, color);
+            }
+        }
     }
 }
 
-void Framebuf::line(int x1, int y1, int x2, int y2, uint16_t color)
+template <typename Fmt>
+void Framebuf::line_t(int x1, int y1, int x2, int y2, uint16_t color)
 {
     int dx = x2 - x1;
     int sx;
@@ -267,14 +491,14 @@ void Framebuf::line(int x1, int y1, int x2, int y2, uint16_t color)
         {
             if (0 <= y1 && y1 < m_nWidth && 0 <= x1 && x1 < m_nHeight)
             {
-                setpixel(y1, x1, color);
+                plot<Fmt>(y1, x1, color);
             }
         }
         else
         {
             if (0 <= x1 && x1 < m_nWidth && 0 <= y1 && y1 < m_nHeight)
             {
-                setpixel(x1, y1, color);
+                plot<Fmt>(x1, y1, color);
             }
         }
         while (e >= 0)
@@ -286,15 +510,15 @@ void Framebuf::line(int x1, int y1, int x2, int y2, uint16_t color)
         e += 2 * dy;
     }
 
-    setpixel(x2, y2, color);
+    if (check(x2, y2))
+    {
+        plot<Fmt>(x2, y2, color);
+    }
 }
 
-void Framebuf::ellipse(int cx, int cy, int xradius, int yradius, uint16_t color, bool bFill, uint8_t mask)
+template <typename Fmt>
+void Framebuf::ellipse_t(int cx, int cy, int xradius, int yradius, uint16_t color, uint8_t mask)
 {
-    if (bFill)
-    {
-        mask |= ELLIPSE_MASK_FILL;
-    }
     int two_asquare   = 2 * xradius * xradius;
     int two_bsquare   = 2 * yradius * yradius;
     int x             = xradius;
@@ -306,7 +530,7 @@ void Framebuf::ellipse(int cx, int cy, int xradius, int yradius, uint16_t color,
     int stoppingy     = 0;
     while (stoppingx >= stoppingy)
     { // 1st set of points,  y' > -1
-        ellipse_points(cx, cy, x, y, color, mask);
+        ellipse_points_t<Fmt>(cx, cy, x, y, color, mask);
         y += 1;
         stoppingy += two_asquare;
         ellipse_error += ychange;
@@ -329,7 +553,7 @@ void Framebuf::ellipse(int cx, int cy, int xradius, int yradius, uint16_t color,
     stoppingy     = two_asquare * yradius;
     while (stoppingx <= stoppingy)
     { // 2nd set of points, y' < -1
-        ellipse_points(cx, cy, x, y, color, mask);
+        ellipse_points_t<Fmt>(cx, cy, x, y, color, mask);
         x += 1;
         stoppingx += two_bsquare;
         ellipse_error += xchange;
@@ -342,70 +566,58 @@ void Framebuf::ellipse(int cx, int cy, int xradius, int yradius, uint16_t color,
             ychange += two_asquare;
         }
     }
-    return;
 }
 
-void Framebuf::text(const char* str, int x, int y, uint16_t color)
+template <typename Fmt>
+void Framebuf::ellipse_points_t(int cx, int cy, int x, int y, uint16_t color, uint8_t mask)
 {
-    // If a default font is set, use it
-    if (m_pFont)
-    {
-        return text(str, x, y, color, *m_pFont, 1);
-    }
-
-    // loop over chars
-    for (; *str; ++str)
+    if (mask & ELLIPSE_MASK_FILL)
     {
-        // get char and make sure its in range of font
-        int chr = *(uint8_t*)str;
-        if (chr < 32 || chr > 127)
+        if (mask & ELLIPSE_MASK_Q1)
         {
-            chr = 127;
+            fillrect_t<Fmt>(cx, cy - y, x + 1, 1, color);
         }
-        // get char data
-        const uint8_t* chr_data = &font_petme128_8x8[(chr - 32) * 8];
-        // loop over char data
-        for (int j = 0; j < 8; j++, x++)
+        if (mask & ELLIPSE_MASK_Q2)
         {
-            if (0 <= x && x < m_nWidth)
-            {                                                        // clip x
-                uint vline_data = chr_data[j];                       // each byte is a column of 8 pixels, LSB at top
-                for (int y1 = y; vline_data; vline_data >>= 1, y1++) // scan over vertical column
-                {
-                    if (vline_data & 1) // only draw if pixel set
-                    {
-                        if (0 <= y1 && y1 < m_nHeight) // clip y
-                        {
-                            setpixel(x, y1, color);
-                        }
-                    }
-                }
+            fillrect_t<Fmt>(cx - x, cy - y, x + 1, 1, color);
+        }
+        if (mask & ELLIPSE_MASK_Q3)
+        {
+            fillrect_t<Fmt>(cx - x, cy + y, x + 1, 1, color);
+        }
+        if (mask & ELLIPSE_MASK_Q4)
+        {
+            fillrect_t<Fmt>(cx, cy + y, x + 1, 1, color);
+        }
+    }
+    else
+    {
+        // Q1 to Q4 are consecutive bits
+        int ax[] = {cx + x, cx - x, cx - x, cx + x};
+        int ay[] = {cy - y, cy - y, cy + y, cy + y};
+        for (int i = 0; i < 4; ++i)
+        {
+            if ((mask & (ELLIPSE_MASK_Q1 << i)) && check(ax[i], ay[i]))
+            {
+                plot<Fmt>(ax[i], ay[i], color);
             }
         }
     }
 }
 
-void Framebuf::text(const char* str, int x, int y, uint16_t color, int scale)
+template <typename Fmt>
+void Framebuf::text_t(const char* str, int x, int y, uint16_t color, int scale)
 {
-    if (scale <= 1)
-    {
-        return text(str, x, y, color);
-    }
-
-    // If a default font is set, use it
-    if (m_pFont)
-    {
-        return text(str, x, y, color, *m_pFont, scale);
-    }
-
     // loop over chars
     for (; *str; ++str)
     {
+        // get char and make sure its in range of font
         int chr = *(uint8_t*)str;
         if (chr < 32 || chr > 127)
         {
             chr = 127;
         }
+        // get char data
         const uint8_t* chr_data = &font_petme128_8x8[(chr - 32) * 8];
 
         int xchar = x; // starting x for this character
@@ -413,10 +625,10 @@ void Framebuf::text(const char* str, int x, int y, uint16_t color, int scale)
         {
             if (0 <= xchar && xchar < m_nWidth)
             {
-                uint vline_data = chr_data[j];
+                uint vline_data = chr_data[j]; // each byte is a column of 8 pixels, LSB at top
                 for (int row = 0; vline_data; vline_data >>= 1, ++row)
                 {
-                    if (vline_data & 1)
+                    if (vline_data & 1) // only draw if pixel set
                     {
                         int ybase = y + row * scale;
                         for (int sx = 0; sx < scale; ++sx)
@@ -427,7 +639,7 @@ void Framebuf::text(const char* str, int x, int y, uint16_t color, int scale)
                                 int py = ybase + sy;
                                 if (0 <= px && px < m_nWidth && 0 <= py && py < m_nHeight)
                                 {
-                                    setpixel(px, py, color);
+                                    plot<Fmt>(px, py, color);
                                 }
                             }
                         }
@@ -439,13 +651,9 @@ void Framebuf::text(const char* str, int x, int y, uint16_t color, int scale)
     }
 }
 
-void Framebuf::text(const char* str, int x, int y, uint16_t color, const BitmapFont& font, int scale)
+template <typename Fmt>
+void Framebuf::text_t(const char* str, int x, int y, uint16_t color, const BitmapFont& font, int scale)
 {
-    if (scale < 1)
-    {
-        scale = 1;
-    }
-
     const int first = font.firstChar;
     const int count = font.charCount;
     const int gw = font.width;
@@ -485,7 +693,7 @@ void Framebuf::text(const char* str, int x, int y, uint16_t color, const BitmapF
                                 int py = ybase + sy;
                                 if (0 <= px && px < (int)m_nWidth && 0 <= py && py < (int)m_nHeight)
                                 {
-                                    setpixel(px, py, color);
+                                    plot<Fmt>(px, py, color);
                                 }
                             }
                         }
@@ -526,7 +734,7 @@ void Framebuf::text(const char* str, int x, int y, uint16_t color, const BitmapF
                                 int py = ybase + sy;
                                 if (0 <= px && px < (int)m_nWidth && 0 <= py && py < (int)m_nHeight)
                                 {
-                                    setpixel(px, py, color);
+                                    plot<Fmt>(px, py, color);
                                 }
                             }
                         }
@@ -538,68 +746,15 @@ void Framebuf::text(const char* str, int x, int y, uint16_t color, const BitmapF
     }
 }
 
-// Private methods
-
-bool Framebuf::check(int& x, int& y)
-{
-    return (0 <= x && x < m_nWidth && 0 <= y && y < m_nHeight);
-}
-
-bool Framebuf::check(int& x, int& y, int& w, int& h)
-{
-    if (w < 1 || h < 1 || x + w <= 0 || y + h <= 0 || x >= m_nWidth || y >= m_nHeight)
-    {
-        return false;
-    }
-    // clip to the framebuffer size
-    int xend = min((int)m_nWidth, x + w);
-    int yend = min((int)m_nHeight, y + h);
-    x        = max(x, 0);
-    y        = max(y, 0);
-    w        = xend - x;
-    h        = yend - y;
-    return true;
-}
-
-void Framebuf::ellipse_points(int cx, int cy, int x, int y, uint16_t color, uint8_t mask)
-{
-    if (mask & ELLIPSE_MASK_FILL)
-    {
-        if (mask & ELLIPSE_MASK_Q1)
-        {
-            fillrect(cx, cy - y, x + 1, 1, color);
-        }
-        if (mask & ELLIPSE_MASK_Q2)
-        {
-            fillrect(cx - x, cy - y, x + 1, 1, color);
-        }
-        if (mask & ELLIPSE_MASK_Q3)
-        {
-            fillrect(cx - x, cy + y, x + 1, 1, color);
-        }
-        if (mask & ELLIPSE_MASK_Q4)
-        {
-            fillrect(cx, cy + y, x + 1, 1, color);
-        }
-    }
-    else
-    {
-        setpixel_masked(cx + x, cy - y, color, mask & ELLIPSE_MASK_Q1);
-        setpixel_masked(cx - x, cy - y, color, mask & ELLIPSE_MASK_Q2);
-        setpixel_masked(cx - x, cy + y, color, mask & ELLIPSE_MASK_Q3);
-        setpixel_masked(cx + x, cy + y, color, mask & ELLIPSE_MASK_Q4);
-    }
-}
-
-void Framebuf::setpixel_masked(int x, int y, uint16_t color, uint8_t mask)
+void Framebuf::scroll(int xstep, int ystep)
 {
-    if (0 != mask && check(x, y))
-    {
-        setpixel(x, y, color);
-    }
+    dispatch([&](auto fmt) {
+        scroll_t<decltype(fmt)>(xstep, ystep);
+    });
 }
 
-void Framebuf::scroll(int xstep, int ystep)
+template <typename Fmt>
+void Framebuf::scroll_t(int xstep, int ystep)
 {
     int sx, y, xend, yend, dx, dy;
     if (xstep < 0)
@@ -646,8 +801,10 @@ void Framebuf::scroll(int xstep, int ystep)
     {
         for (int x = sx; x != xend; x += dx)
         {
-            setpixel(x, y, getpixel(x - xstep, y - ystep));
+            int xfrom      = x - xstep;
+            int yfrom      = y - ystep;
+            uint16_t color = check(xfrom, yfrom) ? Fmt::get(m_pBuf, m_nStride, xfrom, yfrom) : 0;
+            plot<Fmt>(x, y, color);
         }
     }
 }
-
@@ -8,16 +8,10 @@
 #pragma once
 
 #include "pico/stdlib.h"
+#include <algorithm>
 #include <memory>
 #include "font.h"
-
-typedef enum ePixelFormat
-{
-    MVLSB,  // ssd1306
-    RGB565, // ili9341
-    MHLSB,
-    MHMSB,
-} ePixelFormat;
+#include "pixel_format.h"
 
 // Q2 Q1
 // Q3 Q4
@@ -30,6 +24,13 @@ typedef enum ePixelFormat
 
 constexpr bool bReverseBytes = true;
 
+// Framebuf
+//
+// Drawing on a buffer whose pixel format is chosen at run time.  Each call
+// switches on the format once and runs a kernel instantiated for it, so
+// the per-pixel work in text, lines and ellipses is inlined for the format
+// rather than switching on it for every pixel.
+//
 class Framebuf
 {
 public:
@@ -37,7 +38,9 @@ public:
 
     Framebuf();
     ~Framebuf();
-    void Initialize(uint16_t nWidth, uint16_t nHeight, ePixelFormat eFormat, bool bRevBytes = false, uint16_t nStride = 0);
+    // nHeadroom bytes are reserved ahead of buffer(), for a driver to put a
+    // transfer header in front of the pixel data it sends
+    void Initialize(uint16_t nWidth, uint16_t nHeight, ePixelFormat eFormat, bool bRevBytes = false, uint16_t nStride = 0, uint16_t nHeadroom = 0);
 
     void setpixel(int x, int y, uint16_t color);
     uint16_t getpixel(int x, int y);
@@ -73,25 +76,71 @@ public:
         return m_nHeight;
     }
 
+    // Dirty tracking.  Drawing records, for each band of 8 rows (a page in
+    // MVLSB), the span of columns it changed, skipping pixels that already
+    // held the colour, so a display driver can send just those spans and
+    // then clear them.  Direct writers to buffer() should call mark_dirty().
+    bool dirty(uint nBand, uint16_t& x0, uint16_t& x1) const
+    {
+        if (nBand >= m_nBands || m_pDirtyMin[nBand] > m_pDirtyMax[nBand])
+        {
+            return false;
+        }
+        x0 = m_pDirtyMin[nBand];
+        x1 = m_pDirtyMax[nBand];
+        return true;
+    }
+    uint bands() const
+    {
+        return m_nBands;
+    }
+    void mark_dirty(int x, int y, int w, int h);
+    void clear_dirty();
+
 private:
     bool check(int& x, int& y);
     bool check(int& x, int& y, int& h, int& w);
 
-    void ellipse_points(int cx, int cy, int x, int y, uint16_t color, uint8_t mask);
-    void setpixel_masked(int x, int y, uint16_t color, uint8_t mask);
-
     void scroll(int xstep, int ystep);
 
-    uint16_t fixcolor(uint16_t color)
+    // Calls kernel with a PixelFormat for the buffer's format, nothing
+    // without a buffer
+    template <typename Kernel>
+    void dispatch(Kernel&& kernel);
+
+    // Kernels per format, colours already encoded by Fmt::encode()
+    template <typename Fmt>
+    void plot(int x, int y, uint16_t color);
+    template <typename Fmt>
+    void fillrect_t(int x, int y, int w, int h, uint16_t color);
+    template <typename Fmt>
+    void line_t(int x1, int y1, int x2, int y2, uint16_t color);
+    template <typename Fmt>
+    void ellipse_t(int cx, int cy, int xradius, int yradius, uint16_t color, uint8_t mask);
+    template <typename Fmt>
+    void ellipse_points_t(int cx, int cy, int x, int y, uint16_t color, uint8_t mask);
+    template <typename Fmt>
+    void text_t(const char* str, int x, int y, uint16_t color, int scale);
+    template <typename Fmt>
+    void text_t(const char* str, int x, int y, uint16_t color, const BitmapFont& font, int scale);
+    template <typename Fmt>
+    void scroll_t(int xstep, int ystep);
+
+    void dirty_span(uint nBand, int x0, int x1)
     {
-        return m_bRevBytes ? __builtin_bswap16(color) : color;
+        m_pDirtyMin[nBand] = std::min(m_pDirtyMin[nBand], (uint16_t)x0);
+        m_pDirtyMax[nBand] = std::max(m_pDirtyMax[nBand], (uint16_t)x1);
     }
 
     void* m_pBuf;
+    void* m_pAlloc; // m_pBuf less the headroom
     uint16_t m_nWidth;
     uint16_t m_nHeight;
     uint16_t m_nStride;
     ePixelFormat m_eFormat;
     bool m_bRevBytes;
     const BitmapFont* m_pFont;
+    uint16_t m_nBands;
+    uint16_t* m_pDirtyMin; // per band, 0xffff when clean
+    uint16_t* m_pDirtyMax; // per band, 0 when clean
 };
@@ -22,50 +22,52 @@
  * THE SOFTWARE.
  */
 
-#include <queue>
-#include <iostream>
-#include <iomanip>
+#include <string.h>
 
 #include "gps.h"
+#include "nmea.h"
 #include <pico/sync.h>
+#include <hardware/dma.h>
 
-typedef enum eSentenceType
-{
-    kGPGGA,
-    kGPGSA,
-    kGPGSV,
-    kGPRMC,
-    kGPVTG,
-    kPGTOP,
-    kPCD,
-} eSentenceType;
-
-static std::map<std::string, eSentenceType> g_SentenceTypeMap = {
-    {"$GPGGA", kGPGGA},
-    {"$GPGSA", kGPGSA},
-    {"$GPGSV", kGPGSV},
-    {"$GPRMC", kGPRMC},
-    {"$GPVTG", kGPVTG},
-    {"$PGTOP", kPGTOP},
-    {"$PCD",   kPCD  },
-};
-
-static GPS* sg_pGPS          = NULL;
-static uart_inst_t* sg_pUART = nullptr;
+auto constexpr GPS_RX_TRANSFERS = 0xffffffffu; // Re-armed when exhausted
 
 // Static members for RX
-char GPS::sm_szBuffer[GPS_BUFSIZE];
-volatile size_t GPS::sm_iHead      = 0;
-volatile size_t GPS::sm_iNext      = 0;
-volatile size_t GPS::sm_nSentences = 0;
+alignas(GPS_BUFSIZE) char GPS::sm_szBuffer[GPS_BUFSIZE];
 
 GPS::GPS(uart_inst_t* pUART0, uart_inst_t* pUART1)
     : m_pUART0(pUART0),
       m_pUART1(pUART1),
+      m_nRxDMAChannel(-1),
+      m_nRxBase(0),
+      m_nRxScan(0),
+      m_rxTimer(),
+      m_pRxSlot(nullptr),
+      m_bRxDiscard(false),
+      m_pRxUBXSlot(nullptr),
+      m_bRxUBX(false),
+      m_nRxSentences(0),
+      m_nRxUBXFrames(0),
+      m_nRxDroppedSentences(0),
+      m_nRxDroppedBytes(0),
+      m_nRxInvalid(0),
       m_bExit(false),
+      m_bAutoBaud(false),
+      m_autoBaud(),
       m_bGSVInProgress(false),
-      m_nSatListTime(0),
+      m_nNumGSV(0),
+      m_nGSVPart(0),
+      m_nGSVSystem(kSystemUnknown),
+      m_nGSVSignal(0),
+      m_nSatCycle(0),
+      m_nSatAgeTime(0),
       m_bSendGpsData(false),
+      m_gpsData(),
+      m_settingsPMTK(),
+      m_nPMTKBaud(0),
+      m_bPMTKPending(false),
+      m_settingsUBX(),
+      m_nUBXBaud(0),
+      m_bUBXPending(false),
       m_pSentenceCallBack(nullptr),
       m_pSentenceCtx(nullptr),
       m_pGpsDataCallback(nullptr),
@@ -75,6 +77,7 @@ GPS::GPS(uart_inst_t* pUART0, uart_inst_t* pUART1)
 
 GPS::~GPS()
 {
+    stopRx();
 }
 
 void GPS::SetSentenceCallback(void* pCtx, sentenceCallback pCB)
@@ -92,31 +95,58 @@ void GPS::SetGpsDataCallback(void* pCtx, gpsDataCallback pCB)
 void GPS::Run()
 {
     // Set up GPS
-    uart_set_fifo_enabled(m_pUART0, true);
-    sg_pGPS     = this; // Allow interrupt handler to call us back
-    sg_pUART    = m_pUART0;
-    int uartIRQ = m_pUART0 == uart0 ? UART0_IRQ : UART1_IRQ;
-    // Set up and enable the interrupt handler
-    irq_set_exclusive_handler(uartIRQ, on_uart_rx);
-    irq_set_enabled(uartIRQ, true);
-    // Now enable the UART to send interrupts - RX only
-    uart_set_irqs_enabled(m_pUART0, true, false);
-
-    std::string strSentence;
+    startRx();
+    if (m_bAutoBaud)
+    {
+        autoBaud();
+        if (m_autoBaud.bLocked)
+        {
+            m_nPMTKBaud = m_autoBaud.nBaudRate;
+            m_nUBXBaud  = m_autoBaud.nBaudRate;
+        }
+    }
+
+    bool bHeard               = false; // the module has booted and is talking
     bool bSentAntennaCommands = false;
     while (!m_bExit)
     {
-        tight_loop_contents();
+        // Read sentence or frame from GPS device, otherwise doze until the next drain
+        const NMEASentence* pSentence = m_qSentences.Front();
+        const UBXFrame* pFrame        = m_qUBXFrames.Front();
+        if (nullptr == pSentence && nullptr == pFrame)
+        {
+            best_effort_wfe_or_timeout(make_timeout_time_ms(GPS_POLL_MS));
+        }
 
-        // Read sentence from GPS device
-        if (getSentence(strSentence))
+        if (nullptr != pFrame)
         {
-            bool bValidSentenceRead = processSentence(strSentence);
+            bHeard = true; // every queued frame has passed its checksum
+            if (m_ubxConfig.Busy())
+            {
+                m_ubxConfig.OnFrame(*pFrame, time_us_64());
+            }
+            if (processUBX(*pFrame) && nullptr != m_pUART1)
+            {
+                uart_write_blocking(m_pUART1, pFrame->aData, pFrame->nLen);
+            }
+            m_qUBXFrames.Pop();
+        }
+
+        if (nullptr != pSentence)
+        {
+            bool bValidSentenceRead = processSentence(*pSentence);
+            bHeard |= bValidSentenceRead;
+            if (bValidSentenceRead && m_pmtkConfig.Busy())
+            {
+                m_pmtkConfig.OnSentence(*pSentence, time_us_64());
+            }
 
             if (nullptr != m_pUART1 && bValidSentenceRead)
             {
-                uart_puts(m_pUART1, strSentence.c_str()); // Echo to the listening port
+                // Echo to the listening port
+                uart_write_blocking(m_pUART1, reinterpret_cast<const uint8_t*>(pSentence->szData), pSentence->nLen);
             }
+            m_qSentences.Pop();
 
             if (!bSentAntennaCommands && bValidSentenceRead)
             {
@@ -131,118 +161,114 @@ void GPS::Run()
             }
         }
 
+        if (bSentAntennaCommands && m_bPMTKPending)
+        {
+            m_bPMTKPending = false;
+            m_pmtkConfig.Start(m_pUART0, m_settingsPMTK, m_nPMTKBaud);
+        }
+        if (m_pmtkConfig.Busy())
+        {
+            m_pmtkConfig.Step(time_us_64());
+        }
+        if (bHeard && m_bUBXPending)
+        {
+            m_bUBXPending = false;
+            m_ubxConfig.Start(m_pUART0, m_settingsUBX, m_nUBXBaud);
+        }
+        if (m_ubxConfig.Busy())
+        {
+            m_ubxConfig.Step(time_us_64());
+        }
+
         if (m_bSendGpsData)
         {
             m_bSendGpsData = false;
             if (NULL != m_pGpsDataCallback)
             {
-                (*m_pGpsDataCallback)(m_pGpsDataCtx, m_spGPSData);
+                (*m_pGpsDataCallback)(m_pGpsDataCtx, m_gpsData);
             }
         }
     }
 }
 
-bool GPS::processSentence(std::string strSentence)
+// oSentence has been validated and split by the RX parser
+bool GPS::processSentence(const NMEASentence& oSentence)
 {
-    // Validate the string
-    if (!validateSentence(strSentence))
-    {
-        return false;
-    }
-    printf("%s\n", strSentence.c_str());
+    auto svSentence = oSentence.Payload();
+    printf("%.*s\n", (int)svSentence.size(), svSentence.data());
 
     if (NULL != m_pSentenceCallBack)
     {
-        (*m_pSentenceCallBack)(m_pSentenceCtx, strSentence);
+        (*m_pSentenceCallBack)(m_pSentenceCtx, svSentence);
     }
 
-    if (!m_spGPSData)
-    {
-        // Guarantee we have an object to update
-        m_spGPSData           = std::make_shared<GPSData>();
-        m_spGPSData->mSatList = m_mSatListPersistent; // restore any previous data
-    }
-
-    std::vector<std::string> vElems;
-    std::stringstream s_stream(strSentence);
-    while (s_stream.good())
-    {
-        std::string substr;
-        getline(s_stream, substr, ','); // get first string delimited by comma
-        vElems.push_back(substr);
-    }
 
-    if (time_us_64() > m_nSatListTime + 30 * 1000 * 1000) // Nothing in 30 seconds, clear vectors
+    // Age out satellites no longer reported, at most once a second
+    uint32_t nNowMs = (uint32_t)(time_us_64() / 1000);
+    if (nNowMs - m_nSatAgeTime >= 1000)
     {
-        if (!m_spGPSData->mSatList.empty())
+        m_nSatAgeTime = nNowMs;
+        if (!m_gpsData.mSatList.empty())
         {
-            printf("Clearing vectors\n");
-            m_spGPSData->mSatList.clear();
-            m_spGPSData->vUsedList.clear();
+            m_gpsData.mSatList.age(nNowMs, GPS_SAT_AGE_MS);
+            if (m_gpsData.mSatList.empty())
+            {
+                printf("Clearing vectors\n");
+                m_gpsData.vUsedList.clear();
+            }
         }
     }
 
-    if (vElems.size() == 0)
+    // Any talker, satellites are tracked per system
+    auto talker = oSentence.eTalkerId;
+    auto type   = oSentence.eType;
+    if (type == kUnknownSentence)
     {
-        printf("No elements found\n");
+        printf("Not handling %.*s\n", (int)oSentence[0].size(), oSentence[0].data());
         return false;
     }
 
-    if (g_SentenceTypeMap.find(vElems[0]) == g_SentenceTypeMap.end())
-    {
-        printf("Not handling %s\n", vElems[0].c_str());
-        return false;
-    }
-
-    auto type = g_SentenceTypeMap.at(vElems[0]);
-
-    if (m_bGSVInProgress && type != kGPGSV) // Did not complete
+    if (m_bGSVInProgress && type != kGSV) // Did not complete, keep what it updated
     {
         m_bGSVInProgress = false;
-        m_mSatListIncoming.clear();
     }
 
     switch (type)
     {
-    case kGPGGA: // Global Positioning System Fix Data
+    case kGGA: // Global Positioning System Fix Data
     {
-        m_bSendGpsData = true;
-        if (!vElems[7].empty())
+        m_bSendGpsData       = true;
+        m_gpsData.nTimestamp = oSentence.nTimestamp;
+        if (!oSentence[7].empty())
         {
-            m_spGPSData->strNumSats = "Sat: " + vElems[7];
+            m_gpsData.nNumSats = nmea_to_uint(oSentence[7]);
         }
-        if (!vElems[9].empty())
+        if (!oSentence[9].empty())
         {
-            double dMeters = std::stod(vElems[9].c_str());
-            std::stringstream oss;
-            if (dMeters < 1000.0)
-            {
-                oss << std::fixed << std::setfill(' ') << std::setprecision(1) << dMeters << "m";
-            }
-            else
-            {
-                oss << std::setfill(' ') << std::setprecision(0) << dMeters << "m";
-            }
-            m_spGPSData->strAltitude = oss.str();
+            m_gpsData.nAltitude    = nmea_to_fixed(oSentence[9], 3);
+            m_gpsData.bHasAltitude = true;
         }
         break;
     }
-    case kGPGSA: // GPS DOP and active satellites
+    case kGSA: // DOP and active satellites, one per system from multi-GNSS receivers
     {
-        m_spGPSData->vUsedList.clear();
-        m_spGPSData->strMode3D = vElems[2] + "D";
-        if (vElems[2] == "1")
+        m_gpsData.nFixMode = nmea_to_uint(oSentence[2]);
+
+        // NMEA 4.10 names the system, otherwise go by talker or, for GN, PRN
+        uint nSystem = oSentence[18].empty() ? (uint)nmea_talker_system(talker) : (uint)nmea_hex_to_uint(oSentence[18]);
+        if (nSystem == kSystemUnknown)
         {
-            m_spGPSData->strMode3D = "";
+            nSystem = nmea_prn_system(nmea_to_uint(oSentence[3]));
         }
+        m_gpsData.vUsedList.clear(nSystem);
         for (int i = 3; i < 15; ++i)
         {
-            if (!vElems[i].empty())
+            if (!oSentence[i].empty())
             {
-                uint satNum = atoi(vElems[i].c_str());
+                uint satNum = nmea_to_uint(oSentence[i]);
                 if (satNum != 0)
                 {
-                    m_spGPSData->vUsedList.push_back(satNum);
+                    m_gpsData.vUsedList.set(nSystem, satNum);
                 }
             }
             else
@@ -252,101 +278,107 @@ bool GPS::processSentence(std::string strSentence)
         }
         break;
     }
-    case kGPGSV: // GPS Satellites in view
+    case kGSV: // Satellites in view, one multipart cycle per system and signal
     {
-        // Multipart, clear any previous data and re-gather
-        if (vElems[2] == "1")
+        uint nPart        = nmea_to_uint(oSentence[2]);
+        int nNumSatsInGSV = std::min(4, (int)nmea_to_uint(oSentence[3]) - 4 * ((int)nPart - 1));
+        if (nNumSatsInGSV < 0)
+        {
+            nNumSatsInGSV = 0;
+        }
+
+        // NMEA 4.10 appends the signal ID after the satellites
+        uint8_t nSystem = nmea_talker_system(talker);
+        uint8_t nSignal = 0;
+        if (oSentence.size() == 4 + 4 * (size_t)nNumSatsInGSV + 1)
+        {
+            nSignal = nmea_hex_to_uint(oSentence[oSentence.size() - 1]);
+        }
+
+        if (nPart == 1)
         {
-            m_mSatListIncoming.clear();
-            m_strNumGSV      = vElems[1];
+            // New cycle, satellites it reports are stamped with its number
+            ++m_nSatCycle;
+            m_nNumGSV        = nmea_to_uint(oSentence[1]);
+            m_nGSVSystem     = nSystem;
+            m_nGSVSignal     = nSignal;
             m_bGSVInProgress = true;
         }
-        int nNumSatsInGSV = std::min(4, atoi(vElems[3].c_str()) - 4 * (atoi(vElems[2].c_str()) - 1));
-        if (m_bGSVInProgress)
+        else if (nPart != m_nGSVPart + 1 || nSystem != m_nGSVSystem || nSignal != m_nGSVSignal)
         {
-            for (int i = 4; i < 4 + 4 * nNumSatsInGSV; i += 4)
-            {
-                if (!vElems[i].empty() && !vElems[i + 1].empty() && !vElems[i + 2].empty())
-                {
-                    uint num  = atoi(vElems[i].c_str());
-                    uint el   = atoi(vElems[i + 1].c_str());
-                    uint az   = atoi(vElems[i + 2].c_str());
-                    uint rssi = vElems[i + 3].empty() ? 0 : atoi(vElems[i + 3].c_str());
-                    m_mSatListIncoming.emplace(std::make_pair(num, SatInfo(num, el, az, rssi)));
-                }
-            }
-            if (vElems[2] == m_strNumGSV) // Last one received
+            // Lost or interleaved part, cannot tell what left the sky until the next cycle
+            m_bGSVInProgress = false;
+        }
+        m_nGSVPart = nPart;
+
+        // Update in place even from a broken cycle, the reports themselves are good
+        for (int i = 4; i < 4 + 4 * nNumSatsInGSV; i += 4)
+        {
+            if (!oSentence[i].empty() && !oSentence[i + 1].empty() && !oSentence[i + 2].empty())
             {
-                m_bGSVInProgress      = false;
-                m_nSatListTime        = time_us_64();
-                m_spGPSData->mSatList = m_mSatListIncoming;
-                m_mSatListPersistent  = m_spGPSData->mSatList; // Persist the list
+                uint num  = nmea_to_uint(oSentence[i]);
+                uint el   = nmea_to_uint(oSentence[i + 1]);
+                uint az   = nmea_to_uint(oSentence[i + 2]);
+                uint rssi = nmea_to_uint(oSentence[i + 3]);
+                m_gpsData.mSatList.update(SatInfo(num, el, az, rssi, nSystem, nSignal), m_nSatCycle, nNowMs);
             }
         }
+        if (m_bGSVInProgress && nPart == m_nNumGSV) // Last one received
+        {
+            m_bGSVInProgress = false;
+            m_gpsData.mSatList.expire(nSystem, nSignal, m_nSatCycle);
+        }
         break;
     }
-    case kGPRMC: // Recommended minimum specific GPS/Transit data
+    case kRMC: // Recommended minimum specific GPS/Transit data
     {
-        if (!vElems[1].empty())
-        {
-            std::string& t          = vElems[1];
-            m_spGPSData->strGPSTime = t.substr(0, 2) + ":" + t.substr(2, 2) + ":" + t.substr(4, 2) + "Z";
-        }
-        else
-        {
-            m_spGPSData->strGPSTime = "";
-        }
-        if (vElems[2] == "A")
+        m_gpsData.bHasTime = oSentence[1].size() >= 6;
+        m_gpsData.nUTCTime = nmea_to_uint(oSentence[1]);
+        if (oSentence[2] == "A")
         {
-            if (!vElems[3].empty() && !vElems[4].empty() && !vElems[5].empty() && !vElems[6].empty())
+            int32_t nLatitude;
+            int32_t nLongitude;
+            if (nmea_to_degrees(oSentence[3], nLatitude, 90) && !oSentence[4].empty() && nmea_to_degrees(oSentence[5], nLongitude) && !oSentence[6].empty())
             {
-                m_spGPSData->bHasPosition = true;
-                m_spGPSData->strLatitude  = convertToDegrees(vElems[3], 7) + vElems[4];
-                m_spGPSData->strLongitude = convertToDegrees(vElems[5], 8) + vElems[6];
+                m_gpsData.bHasPosition = true;
+                m_gpsData.bHasLatLon   = true;
+                m_gpsData.nLatitude    = oSentence[4] == "S" ? -nLatitude : nLatitude;
+                m_gpsData.nLongitude   = oSentence[6] == "W" ? -nLongitude : nLongitude;
             }
-            if (!vElems[7].empty())
+            if (!oSentence[7].empty())
             {
-                double dKnots = std::stod(vElems[7].c_str());
-                double dMph   = dKnots * 1.15078;
-                std::stringstream oss;
-                if (dMph < 10.0)
-                {
-                    oss << std::fixed << std::setfill(' ') << std::setprecision(1) << dMph << "mph";
-                }
-                else
-                {
-                    oss << std::setfill(' ') << std::setprecision(0) << dMph << "mph";
-                }
-                m_spGPSData->strSpeed = oss.str();
+                // 1 knot = 185200 cm / 3600 s, so cm/s = knots/1000 * 463 / 9000
+                m_gpsData.nSpeed    = (uint32_t)nmea_to_fixed(oSentence[7], 3) * 463 / 9000;
+                m_gpsData.bHasSpeed = true;
             }
         }
         else
         {
-            m_spGPSData->bHasPosition = false;
+            m_gpsData.bHasPosition = false;
         }
         break;
     }
     case kPGTOP: // PA6H External antenna info
     {
-        if (vElems[2] == "2")
+        if (oSentence[2] == "2")
         {
-            m_spGPSData->bExternalAntenna = false;
+            m_gpsData.bExternalAntenna = false;
         }
-        if (vElems[2] == "3")
+        if (oSentence[2] == "3")
         {
-            m_spGPSData->bExternalAntenna = true;
+            m_gpsData.bExternalAntenna = true;
         }
         break;
     }
     case kPCD: // PA1616S External antenna info
     {
-        if (vElems[2] == "1")
+        if (oSentence[2] == "1")
         {
-            m_spGPSData->bExternalAntenna = false;
+            m_gpsData.bExternalAntenna = false;
         }
-        if (vElems[2] == "2")
+        if (oSentence[2] == "2")
         {
-            m_spGPSData->bExternalAntenna = true;
+            m_gpsData.bExternalAntenna = true;
         }
         break;
     }
@@ -356,89 +388,471 @@ bool GPS::processSentence(std::string strSentence)
     return true;
 }
 
-bool GPS::validateSentence(std::string& strSentence)
+void GPS::ConfigurePMTK(const PMTKSettings& settings, uint nCurrentBaud)
+{
+    m_settingsPMTK = settings;
+    m_nPMTKBaud    = nCurrentBaud;
+    m_bPMTKPending = true;
+}
+
+void GPS::ConfigureUBX(uint nBaudRate, uint nCurrentBaud, uint nMeasRateMs)
 {
-    // Validate format and remove checksum and CRLF
-    size_t nLen = strSentence.size();
-    if (nLen < 1 || strSentence[0] != '$')
+    m_settingsUBX = {nBaudRate, (uint16_t)nMeasRateMs};
+    m_nUBXBaud    = nCurrentBaud;
+    m_bUBXPending = true;
+}
+
+// oFrame has passed its checksum in the RX path
+bool GPS::processUBX(const UBXFrame& oFrame)
+{
+    if (oFrame.nClass != UBX_CLASS_NAV)
     {
         return false;
     }
-    if (nLen < 6 || strSentence.substr(nLen - 2, 2) != "\r\n" || strSentence[nLen - 5] != '*')
+
+    const uint8_t* pPayload = oFrame.Payload();
+    switch (oFrame.nId)
     {
-        return false;
+    case UBX_NAV_PVT: // Position, velocity and time, all native integers
+    {
+        if (oFrame.nPayloadLen < UBX_PVT_LEN)
+        {
+            return false;
+        }
+        uint8_t nFixType = pPayload[UBX_PVT_FIX_TYPE];
+        bool bFixOK      = (pPayload[UBX_PVT_FLAGS] & 0x01) && nFixType >= 2 && nFixType <= 4;
+
+        m_bSendGpsData         = true;
+        m_gpsData.nTimestamp   = oFrame.nTimestamp;
+        m_gpsData.bHasPosition = bFixOK;
+        m_gpsData.nFixMode     = bFixOK ? std::min<uint8_t>(nFixType, 3) : 1;
+        m_gpsData.nNumSats     = std::min<uint8_t>(pPayload[UBX_PVT_NUM_SV], INT8_MAX);
+        if (pPayload[UBX_PVT_VALID] & 0x02)
+        {
+            m_gpsData.bHasTime = true;
+            m_gpsData.nUTCTime = pPayload[UBX_PVT_HOUR] * 10000 + pPayload[UBX_PVT_MIN] * 100 + pPayload[UBX_PVT_SEC];
+        }
+        if (bFixOK)
+        {
+            m_gpsData.bHasLatLon   = true;
+            m_gpsData.nLatitude    = ubx_i32(pPayload + UBX_PVT_LAT);
+            m_gpsData.nLongitude   = ubx_i32(pPayload + UBX_PVT_LON);
+            m_gpsData.bHasAltitude = true;
+            m_gpsData.nAltitude    = ubx_i32(pPayload + UBX_PVT_HMSL);
+            m_gpsData.bHasSpeed    = true;
+            m_gpsData.nSpeed       = std::max<int32_t>(ubx_i32(pPayload + UBX_PVT_GSPEED), 0) / 10; // mm/s to cm/s
+        }
+        return true;
     }
-    std::string specifiedCheck  = strSentence.substr(nLen - 4, 2);
-    std::string calculatedCheck = checkSum(strSentence.substr(1, nLen - 6));
-    if (calculatedCheck != specifiedCheck)
+    case UBX_NAV_SAT: // Every satellite of every system in one message
     {
+        if (oFrame.nPayloadLen < UBX_SAT_BLOCK)
+        {
+            return false;
+        }
+        uint nSvs = pPayload[UBX_SAT_NUM_SVS];
+        if (UBX_SAT_BLOCK + nSvs * UBX_SAT_BLOCK_LEN > oFrame.nPayloadLen)
+        {
+            return false;
+        }
+
+        uint32_t nNowMs = (uint32_t)(time_us_64() / 1000);
+        ++m_nSatCycle;
+        m_gpsData.vUsedList.clear();
+        for (uint i = 0; i < nSvs; ++i)
+        {
+            const uint8_t* pSat = pPayload + UBX_SAT_BLOCK + i * UBX_SAT_BLOCK_LEN;
+            uint nSystem        = ubx_gnss_system(pSat[0]);
+            uint nPRN           = pSat[1];
+            int8_t nElevation   = (int8_t)pSat[3];
+            int16_t nAzimuth    = (int16_t)ubx_u16(pSat + 4);
+            if (pSat[8] & UBX_SAT_USED)
+            {
+                m_gpsData.vUsedList.set(nSystem, nPRN);
+            }
+            if (nElevation >= 0 && nAzimuth >= 0) // unknown positions are reported negative
+            {
+                m_gpsData.mSatList.update(SatInfo(nPRN, nElevation, nAzimuth, pSat[2], nSystem, 0), m_nSatCycle, nNowMs);
+            }
+        }
+        m_gpsData.mSatList.expire(m_nSatCycle); // one message is a complete sky view
+        return true;
+    }
+    default:
         return false;
     }
+}
 
-    strSentence = strSentence.substr(0, nLen - 5);
+bool SatList::update(const SatInfo& oSat, uint8_t nCycle, uint32_t nNowMs)
+{
+    // Binary search for the entry, or where it belongs
+    uint32_t nKey = oSat.Key();
+    uint16_t i    = 0;
+    uint16_t nEnd = m_nCount;
+    while (i < nEnd)
+    {
+        uint16_t nMid = (i + nEnd) / 2;
+        if (m_aSats[nMid].Key() < nKey)
+        {
+            i = nMid + 1;
+        }
+        else
+        {
+            nEnd = nMid;
+        }
+    }
 
+    if (i < m_nCount && m_aSats[i].Key() == nKey)
+    {
+        SatInfo& oEntry = m_aSats[i];
+        if (oEntry.m_el != oSat.m_el || oEntry.m_az != oSat.m_az || oEntry.m_rssi != oSat.m_rssi)
+        {
+            oEntry.m_el       = oSat.m_el;
+            oEntry.m_az       = oSat.m_az;
+            oEntry.m_rssi     = oSat.m_rssi;
+            oEntry.m_nVersion = ++m_nVersion;
+        }
+        oEntry.m_nCycle = nCycle;
+        oEntry.m_nSeen  = nNowMs;
+        return true;
+    }
+    if (m_nCount == GPS_MAX_SATS)
+    {
+        return false;
+    }
+    memmove(&m_aSats[i + 1], &m_aSats[i], (m_nCount - i) * sizeof(SatInfo));
+    m_aSats[i]            = oSat;
+    m_aSats[i].m_nCycle   = nCycle;
+    m_aSats[i].m_nSeen    = nNowMs;
+    m_aSats[i].m_nVersion = ++m_nVersion;
+    ++m_nCount;
     return true;
 }
 
-std::string GPS::checkSum(const std::string& strSentence)
+template <typename Pred>
+void SatList::removeIf(Pred pred)
 {
-    uint8_t check = 0;
-    for (const char& c : strSentence)
+    uint16_t nKept = 0;
+    for (uint16_t i = 0; i < m_nCount; ++i)
     {
-        check ^= (uint8_t)c;
+        if (!pred(m_aSats[i]))
+        {
+            m_aSats[nKept++] = m_aSats[i];
+        }
+    }
+    if (nKept != m_nCount)
+    {
+        m_nCount = nKept;
+        ++m_nVersion;
     }
-    std::stringstream oss;
-    oss << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << (unsigned int)check;
-    return oss.str();
 }
 
-std::string GPS::convertToDegrees(std::string strRaw, int width)
+void SatList::expire(uint nSys, uint nSig, uint8_t nCycle)
 {
-    // Convert (D)DDMM.mmmm to decimal degrees
-    double dRawAsDouble = stod(strRaw);
-    int firstdigits     = int(dRawAsDouble / 100);
-    int nexttwodigits   = dRawAsDouble - double(firstdigits * 100);
-    double converted    = double(firstdigits) + nexttwodigits / 60.0;
-    std::stringstream oss;
-    oss << std::fixed << std::setw(width) << std::setfill(' ') << std::setprecision(4) << converted;
-    return oss.str();
+    uint32_t nRun = (nSys << 8) | nSig;
+    removeIf([nRun, nCycle](const SatInfo& oSat) { return (oSat.Key() >> 16) == nRun && oSat.m_nCycle != nCycle; });
+}
+
+void SatList::expire(uint8_t nCycle)
+{
+    removeIf([nCycle](const SatInfo& oSat) { return oSat.m_nCycle != nCycle; });
+}
+
+void SatList::age(uint32_t nNowMs, uint32_t nMaxAgeMs)
+{
+    removeIf([nNowMs, nMaxAgeMs](const SatInfo& oSat) { return nNowMs - oSat.m_nSeen > nMaxAgeMs; });
+}
+
+GPSRxStats GPS::GetRxStats() const
+{
+    GPSRxStats stats;
+    stats.nSentences        = m_nRxSentences.load(std::memory_order_relaxed);
+    stats.nUBXFrames        = m_nRxUBXFrames.load(std::memory_order_relaxed);
+    stats.nDroppedSentences = m_nRxDroppedSentences.load(std::memory_order_relaxed);
+    stats.nDroppedBytes     = m_nRxDroppedBytes.load(std::memory_order_relaxed);
+    stats.nInvalid          = m_nRxInvalid.load(std::memory_order_relaxed);
+    stats.nHighWater        = m_qSentences.HighWater();
+    stats.nUBXHighWater     = m_qUBXFrames.HighWater();
+    return stats;
+}
+
+void GPS::startRx()
+{
+    // The UART raises its RX DREQ whenever the FIFO holds data, so the DMA
+    // channel drains it into the ring without any CPU involvement.
+    uart_set_fifo_enabled(m_pUART0, true);
+    uart_set_irqs_enabled(m_pUART0, false, false);
+
+    m_nRxDMAChannel        = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(m_nRxDMAChannel);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_ring(&cfg, true, GPS_BUFSIZE_BITS);
+    channel_config_set_dreq(&cfg, uart_get_dreq(m_pUART0, false));
+    dma_channel_configure(m_nRxDMAChannel, &cfg, sm_szBuffer, &uart_get_hw(m_pUART0)->dr, GPS_RX_TRANSFERS, true);
+
+    // Move whole sentences out of the ring at a fixed cadence
+    add_repeating_timer_ms(GPS_POLL_MS, onRxTimer, this, &m_rxTimer);
+}
+
+void GPS::stopRx()
+{
+    if (m_nRxDMAChannel >= 0)
+    {
+        cancel_repeating_timer(&m_rxTimer);
+        dma_channel_abort(m_nRxDMAChannel);
+        dma_channel_unclaim(m_nRxDMAChannel);
+        m_nRxDMAChannel = -1;
+    }
+}
+
+uint32_t GPS::rxWritten()
+{
+    if (!dma_channel_is_busy(m_nRxDMAChannel))
+    {
+        // Transfer count exhausted (days at high baud), re-arm and carry on
+        // from where the write address wrapped to.
+        m_nRxBase += GPS_RX_TRANSFERS;
+        dma_channel_set_trans_count(m_nRxDMAChannel, GPS_RX_TRANSFERS, true);
+    }
+    return m_nRxBase + (GPS_RX_TRANSFERS - dma_channel_hw_addr(m_nRxDMAChannel)->transfer_count);
+}
+
+bool GPS::onRxTimer(repeating_timer_t* pTimer)
+{
+    GPS* pThis = reinterpret_cast<GPS*>(pTimer->user_data);
+    pThis->drainRx();
+    return true; // keep repeating
+}
+
+// Producer side of m_qSentences, runs in the timer interrupt
+void GPS::drainRx()
+{
+    uint32_t nWritten = rxWritten();
+    if (nWritten - m_nRxScan > GPS_BUFSIZE)
+    {
+        // DMA lapped us, everything unread is suspect
+        uint32_t nLost = nWritten - m_nRxScan;
+        dropRxSentence(nLost);
+        m_nRxScan    = nWritten;
+        m_bRxDiscard = true; // resynchronize on the next line
+        m_bRxUBX     = false;
+    }
+
+    while (m_nRxScan != nWritten)
+    {
+        char ch = sm_szBuffer[m_nRxScan++ & (GPS_BUFSIZE - 1)];
+
+        // UBX frames can only start between NMEA lines, their sync byte is never ASCII
+        if (m_bRxUBX || ((uint8_t)ch == UBX_SYNC1 && (m_bRxDiscard || nullptr == m_pRxSlot || 0 == m_pRxSlot->nLen)))
+        {
+            m_bRxDiscard = false;
+            rxUBX(ch);
+            continue;
+        }
+        if (m_bRxDiscard)
+        {
+            if (ch != '$')
+            {
+                m_nRxDroppedBytes.store(m_nRxDroppedBytes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                m_bRxDiscard = (ch != '\n');
+                continue;
+            }
+            m_bRxDiscard = false; // the next sentence starts here
+        }
+        if (nullptr == m_pRxSlot)
+        {
+            m_pRxSlot = m_qSentences.BeginPush();
+            if (nullptr == m_pRxSlot)
+            {
+                // Queue full, lose this line rather than anything already queued
+                dropRxSentence(1);
+                m_bRxDiscard = (ch != '\n');
+                continue;
+            }
+            m_rxParser.Begin(m_pRxSlot);
+        }
+
+        // Validate and split as we go so bad lines never reach the queue
+        switch (m_rxParser.Feed(ch))
+        {
+        case NMEAParser::kSentence:
+            m_pRxSlot->nTimestamp = time_us_64();
+            m_qSentences.CommitPush();
+            m_pRxSlot = nullptr;
+            m_nRxSentences.store(m_nRxSentences.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            break;
+        case NMEAParser::kBad:
+            m_nRxInvalid.store(m_nRxInvalid.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (ch == '$')
+            {
+                // Cut short by the next sentence, read its '$' again as the start
+                m_nRxDroppedBytes.store(m_nRxDroppedBytes.load(std::memory_order_relaxed) + m_pRxSlot->nLen - 1, std::memory_order_relaxed);
+                --m_nRxScan;
+            }
+            else
+            {
+                m_nRxDroppedBytes.store(m_nRxDroppedBytes.load(std::memory_order_relaxed) + m_pRxSlot->nLen, std::memory_order_relaxed);
+                m_bRxDiscard = (ch != '\n');
+            }
+            m_rxParser.Begin(m_pRxSlot);
+            break;
+        case NMEAParser::kOverlength:
+            // Cannot be NMEA, the byte that overflowed was not stored
+            if (ch == '$')
+            {
+                dropRxSentence(0);
+                --m_nRxScan;
+            }
+            else
+            {
+                dropRxSentence(1);
+                m_bRxDiscard = (ch != '\n');
+            }
+            break;
+        default:
+            break;
+        }
+    }
 }
 
-// RX interrupt handler
-void GPS::on_uart_rx()
+// Listen at each candidate rate in turn until one yields clean frames.  At
+// the wrong rate the bytes are noise that fails validation almost at once,
+// so a wrong guess costs little while a silent module costs a full window.
+void GPS::autoBaud()
 {
-    uart_set_irqs_enabled(sg_pUART, false, false);
-    while (uart_is_readable(sg_pUART))
+    auto constexpr nRates = sizeof(GPS_AUTOBAUD_RATES) / sizeof(GPS_AUTOBAUD_RATES[0]);
+
+    uint64_t nStart      = time_us_64();
+    uint64_t nGiveUp     = nStart + GPS_AUTOBAUD_TIMEOUT_MS * 1000ull;
+    uint nBestRate       = 0;
+    int32_t nBestScore   = 0;
+    m_autoBaud           = GPSAutoBaud();
+    m_autoBaud.nBaudRate = GPS_AUTOBAUD_RATES[0];
+
+    for (size_t i = 0; !m_bExit && time_us_64() < nGiveUp; i = (i + 1) % nRates)
     {
-        char ch                 = uart_getc(sg_pUART);
-        sm_szBuffer[sm_iNext++] = ch;
-        sm_iNext %= GPS_BUFSIZE;
-        if (ch == '\n')
+        uint nRate = GPS_AUTOBAUD_RATES[i];
+        uart_set_baudrate(m_pUART0, nRate);
+        ++m_autoBaud.nRatesTried;
+
+        // Let the drain pass anything received at the previous rate
+        best_effort_wfe_or_timeout(make_timeout_time_ms(2 * GPS_POLL_MS));
+        discardRx();
+
+        uint32_t nJunkBase = m_nRxDroppedBytes.load(std::memory_order_relaxed);
+        uint32_t nJunk     = 0;
+        uint nClean        = 0;
+        uint64_t nWindow   = time_us_64() + GPS_AUTOBAUD_WINDOW_MS * 1000ull;
+        while (!m_bExit && time_us_64() < nWindow)
         {
-            sm_szBuffer[sm_iNext++] = '\0';
-            sm_iNext %= GPS_BUFSIZE;
-            sm_nSentences += 1;
+            best_effort_wfe_or_timeout(make_timeout_time_ms(GPS_POLL_MS));
+            nClean += discardRx();
+            nJunk = m_nRxDroppedBytes.load(std::memory_order_relaxed) - nJunkBase;
+            if (nClean >= GPS_AUTOBAUD_LOCK || (0 == nClean && nJunk >= GPS_AUTOBAUD_JUNK))
+            {
+                break;
+            }
+        }
+
+        // A frame passing its checksum by chance is rare, noise alongside it is not
+        int32_t nScore = (int32_t)nClean * 64 - (int32_t)nJunk;
+        if ((nClean > 0 && nScore > nBestScore) || nClean >= GPS_AUTOBAUD_LOCK)
+        {
+            nBestRate  = nRate;
+            nBestScore = nScore;
         }
+        if (nClean >= GPS_AUTOBAUD_LOCK || (i == nRates - 1 && 0 != nBestRate))
+        {
+            break;
+        }
+    }
+
+    if (0 != nBestRate)
+    {
+        m_autoBaud.bLocked   = true;
+        m_autoBaud.nBaudRate = nBestRate;
     }
-    uart_set_irqs_enabled(sg_pUART, true, false);
+    uart_set_baudrate(m_pUART0, m_autoBaud.nBaudRate);
+    m_autoBaud.nTimeToLockMs = (uint32_t)((time_us_64() - nStart) / 1000);
+    printf("Autobaud %s %u after %u ms, %u rates tried\n",
+           m_autoBaud.bLocked ? "locked at" : "gave up, staying at",
+           m_autoBaud.nBaudRate,
+           (unsigned)m_autoBaud.nTimeToLockMs,
+           m_autoBaud.nRatesTried);
 }
 
-bool GPS::getSentence(std::string& strSentence)
+// Pop everything queued, returning how many sentences and frames there were
+uint GPS::discardRx()
 {
-    bool bFound = false;
-    uart_set_irqs_enabled(sg_pUART, false, false);
-    if (sm_nSentences > 0)
+    uint nCount = 0;
+    for (; nullptr != m_qSentences.Front(); ++nCount)
+    {
+        m_qSentences.Pop();
+    }
+    for (; nullptr != m_qUBXFrames.Front(); ++nCount)
+    {
+        m_qUBXFrames.Pop();
+    }
+    return nCount;
+}
+
+// Producer side of m_qUBXFrames, one byte of a binary frame
+void GPS::rxUBX(uint8_t ch)
+{
+    if (!m_bRxUBX)
+    {
+        m_bRxUBX     = true;
+        m_pRxUBXSlot = m_qUBXFrames.BeginPush();
+        m_rxUBXParser.Begin(nullptr != m_pRxUBXSlot ? m_pRxUBXSlot : &m_rxUBXSkip);
+    }
+
+    UBXFrame* pFrame = nullptr != m_pRxUBXSlot ? m_pRxUBXSlot : &m_rxUBXSkip;
+    switch (m_rxUBXParser.Feed(ch))
     {
-        strSentence.clear();
-        for (size_t i = sm_iHead; '\0' != sm_szBuffer[i]; i = (i + 1) % GPS_BUFSIZE)
+    case UBXParser::kFrame:
+        if (nullptr != m_pRxUBXSlot)
+        {
+            m_pRxUBXSlot->nTimestamp = time_us_64();
+            m_qUBXFrames.CommitPush();
+            m_nRxUBXFrames.store(m_nRxUBXFrames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        else
         {
-            strSentence += sm_szBuffer[i];
+            // Queue full, lose this frame rather than anything already queued
+            m_nRxDroppedSentences.store(m_nRxDroppedSentences.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            m_nRxDroppedBytes.store(m_nRxDroppedBytes.load(std::memory_order_relaxed) + pFrame->nLen, std::memory_order_relaxed);
         }
-        sm_iHead = (sm_iHead + strSentence.length() + 1) % GPS_BUFSIZE;
-        sm_nSentences -= 1;
-        bFound = true;
+        m_bRxUBX = false;
+        break;
+    case UBXParser::kBad:
+        m_nRxInvalid.store(m_nRxInvalid.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_nRxDroppedBytes.store(m_nRxDroppedBytes.load(std::memory_order_relaxed) + pFrame->nLen, std::memory_order_relaxed);
+        m_bRxUBX = false;
+        break;
+    case UBXParser::kOverlength:
+        // Cannot skip it by length, resynchronize on the next NMEA line or UBX sync
+        m_nRxDroppedSentences.store(m_nRxDroppedSentences.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_nRxDroppedBytes.store(m_nRxDroppedBytes.load(std::memory_order_relaxed) + pFrame->nLen, std::memory_order_relaxed);
+        m_bRxUBX     = false;
+        m_bRxDiscard = true;
+        break;
+    default:
+        break;
     }
-    uart_set_irqs_enabled(sg_pUART, true, false);
+}
 
-    return bFound;
+// Account for the line being assembled (if any) plus nBytes not yet stored,
+// and reset so the next line starts cleanly
+void GPS::dropRxSentence(uint32_t nBytes)
+{
+    if (nullptr != m_pRxSlot)
+    {
+        nBytes += m_pRxSlot->nLen;
+        m_pRxSlot->nLen = 0;
+        m_pRxSlot       = nullptr;
+    }
+    m_nRxDroppedSentences.store(m_nRxDroppedSentences.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_nRxDroppedBytes.store(m_nRxDroppedBytes.load(std::memory_order_relaxed) + nBytes, std::memory_order_relaxed);
 }
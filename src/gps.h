@@ -10,62 +10,252 @@
 #include <pico/stdlib.h>
 #include <hardware/uart.h>
 #include <string>
-#include <vector>
-#include <map>
+#include <string_view>
+#include <type_traits>
 #include <memory>
+#include <atomic>
+
+#include "spsc_queue.h"
+#include "nmea.h"
+#include "ubx.h"
+#include "pmtk.h"
+
+auto constexpr GPS_MAX_SATS   = 128;   // Satellites in view across all constellations and signals
+auto constexpr GPS_MAX_PRN    = 256;   // PRNs at or above this are not tracked as used
+auto constexpr GPS_SAT_AGE_MS = 10000; // Satellites not reported for this long are dropped
 
 class SatInfo
 {
 public:
-    SatInfo(uint num = 0, uint el = 0, uint az = 0, uint rssi = 0)
+    SatInfo(uint num = 0, uint el = 0, uint az = 0, uint rssi = 0, uint sys = kSystemUnknown, uint sig = 0)
     {
-        m_num  = num;
-        m_el   = el;
-        m_az   = az;
-        m_rssi = rssi;
+        m_num      = num;
+        m_az       = az;
+        m_el       = el;
+        m_rssi     = rssi;
+        m_sys      = sys;
+        m_sig      = sig;
+        m_nCycle   = 0;
+        m_nSeen    = 0;
+        m_nVersion = 0;
     }
-    ~SatInfo()
+
+    // Sort key, so that each system and signal is one contiguous run
+    uint32_t Key() const
     {
+        return ((uint32_t)m_sys << 24) | ((uint32_t)m_sig << 16) | m_num;
     }
 
-    uint m_num;
-    uint m_el;
-    uint m_az;
-    uint m_rssi;
+    uint16_t m_num;
+    uint16_t m_az;
+    uint8_t m_el;
+    uint8_t m_rssi;
+    uint8_t m_sys;       // eGNSSystem, kSystemUnknown for combined GN cycles
+    uint8_t m_sig;       // NMEA 4.10 signal ID, 0 if not reported
+    uint8_t m_nCycle;    // GSV cycle or NAV-SAT epoch that last reported it
+    uint32_t m_nSeen;    // ms timestamp of the last report
+    uint32_t m_nVersion; // SatList::Version() when its position or SNR last changed
 };
 
-typedef std::map<uint, SatInfo> SatList;
-typedef std::vector<uint> UsedList;
+// SatList
+//
+// Fixed-capacity sky view kept sorted by system, signal and PRN, so it can
+// be copied with a memcpy.  Reports update satellites in place and stamp
+// them as seen, a completed cycle drops only the satellites of its own run
+// it no longer reported, and anything unreported for long enough ages out.
+// Every change bumps the list version and is recorded in the changed
+// satellite, so a consumer holding an older snapshot can tell whether
+// anything moved at all, and if so which satellites.
+//
+class SatList
+{
+public:
+    SatList()
+        : m_nCount(0),
+          m_nVersion(0)
+    {
+    }
 
-class GPSData
+    // Update oSat in place or add it, marking it seen in nCycle at nNowMs
+    bool update(const SatInfo& oSat, uint8_t nCycle, uint32_t nNowMs);
+    // Drop entries for nSys and nSig, or for every system, not seen in nCycle
+    void expire(uint nSys, uint nSig, uint8_t nCycle);
+    void expire(uint8_t nCycle);
+    // Drop entries not seen within nMaxAgeMs of nNowMs
+    void age(uint32_t nNowMs, uint32_t nMaxAgeMs);
+    void clear()
+    {
+        if (0 != m_nCount)
+        {
+            m_nCount = 0;
+            ++m_nVersion;
+        }
+    }
+    size_t size() const
+    {
+        return m_nCount;
+    }
+    bool empty() const
+    {
+        return 0 == m_nCount;
+    }
+    const SatInfo* begin() const
+    {
+        return m_aSats;
+    }
+    const SatInfo* end() const
+    {
+        return m_aSats + m_nCount;
+    }
+    // Bumped whenever a satellite is added, removed or changes
+    uint32_t Version() const
+    {
+        return m_nVersion;
+    }
+
+private:
+    template <typename Pred>
+    void removeIf(Pred pred);
+
+    SatInfo m_aSats[GPS_MAX_SATS];
+    uint16_t m_nCount;
+    uint32_t m_nVersion;
+};
+
+// UsedList
+//
+// Bitsets of the PRNs used in the current fix, one per system since PRNs
+// are only unique within a constellation
+//
+class UsedList
 {
 public:
-    typedef std::shared_ptr<GPSData> Shared;
+    UsedList()
+    {
+        clear();
+    }
+
+    void set(uint sys, uint prn)
+    {
+        if (sys < kNumSystems && prn < GPS_MAX_PRN)
+        {
+            m_aBits[sys][prn / 32] |= 1u << (prn % 32);
+        }
+    }
+    bool test(uint sys, uint prn) const
+    {
+        return sys < kNumSystems && prn < GPS_MAX_PRN && (m_aBits[sys][prn / 32] & (1u << (prn % 32)));
+    }
+    void clear(uint sys)
+    {
+        if (sys < kNumSystems)
+        {
+            for (auto& nBits : m_aBits[sys])
+            {
+                nBits = 0;
+            }
+        }
+    }
+    void clear()
+    {
+        for (uint sys = 0; sys < kNumSystems; ++sys)
+        {
+            clear(sys);
+        }
+    }
 
+private:
+    uint32_t m_aBits[kNumSystems][GPS_MAX_PRN / 32];
+};
+
+// GPSData
+//
+// Plain data, no heap members, so a snapshot is a single memcpy.
+//
+class GPSData
+{
+public:
     GPSData()
-        : bHasPosition(false),
-          bExternalAntenna(false)
+        : nTimestamp(0),
+          bHasPosition(false),
+          bExternalAntenna(false),
+          bHasLatLon(false),
+          bHasAltitude(false),
+          bHasSpeed(false),
+          bHasTime(false),
+          nNumSats(-1),
+          nFixMode(0),
+          nLatitude(0),
+          nLongitude(0),
+          nAltitude(0),
+          nSpeed(0),
+          nUTCTime(0)
     {
     }
     ~GPSData() = default;
 
-    bool bHasPosition;
+    uint64_t nTimestamp; // time_us_64() when the sentence or frame that completed it was parsed
+    bool bHasPosition;   // current RMC status is valid
     bool bExternalAntenna;
-    std::string strLatitude;
-    std::string strLongitude;
-    std::string strAltitude;
-    std::string strNumSats;
-    std::string strGPSTime;
-    std::string strMode3D;
-    std::string strSpeed;
+    bool bHasLatLon; // the fields below have been reported at least once
+    bool bHasAltitude;
+    bool bHasSpeed;
+    bool bHasTime;
+    int8_t nNumSats;    // -1 until reported
+    uint8_t nFixMode;   // GSA mode, 2 = 2D, 3 = 3D
+    int32_t nLatitude;  // 1e-7 degrees, north positive
+    int32_t nLongitude; // 1e-7 degrees, east positive
+    int32_t nAltitude;  // mm above mean sea level
+    uint32_t nSpeed;    // cm/s over ground
+    uint32_t nUTCTime;  // hhmmss
     SatList mSatList;
     UsedList vUsedList;
+
+    bool IsUsed(const SatInfo& oSat) const
+    {
+        // Combined GN cycles carry no system, fall back to the PRN range
+        return vUsedList.test(oSat.m_sys != kSystemUnknown ? (uint)oSat.m_sys : (uint)nmea_prn_system(oSat.m_num), oSat.m_num);
+    }
 };
 
-typedef void (*sentenceCallback)(void* pCtx, std::string strSentence);
-typedef void (*gpsDataCallback)(void* pCtx, GPSData::Shared spGPSData);
+static_assert(std::is_trivially_copyable<GPSData>::value, "GPSData snapshots must be memcpy-able");
+
+typedef void (*sentenceCallback)(void* pCtx, std::string_view svSentence); // valid for the call only
+typedef void (*gpsDataCallback)(void* pCtx, const GPSData& gpsData); // valid for the call only
+
+auto constexpr GPS_BUFSIZE_BITS       = 12;                    // DMA ring wrap size, log2
+auto constexpr GPS_BUFSIZE            = 1u << GPS_BUFSIZE_BITS; // Circular buffer size
+auto constexpr GPS_SENTENCE_SLOTS     = 16;                    // Sentence queue depth, power of two
+auto constexpr GPS_UBX_SLOTS          = 4;                     // UBX frame queue depth, power of two
+auto constexpr GPS_POLL_MS            = 10;                    // RX ring drain interval
+
+// Baud rate detection, candidates in the order tried, factory defaults first
+constexpr uint GPS_AUTOBAUD_RATES[]    = {9600, 38400, 115200, 57600, 19200, 4800};
+auto constexpr GPS_AUTOBAUD_WINDOW_MS  = 1100;  // longest listen per rate, catches one 1 Hz burst
+auto constexpr GPS_AUTOBAUD_LOCK       = 2;     // clean frames to lock on a rate
+auto constexpr GPS_AUTOBAUD_JUNK       = 48;    // bytes of noise, with nothing clean, to abandon a rate
+auto constexpr GPS_AUTOBAUD_TIMEOUT_MS = 15000; // give up and stay at the first candidate
 
-auto constexpr GPS_BUFSIZE            = 4096; // Circular buffer size
+// Outcome of baud rate detection
+struct GPSAutoBaud
+{
+    bool bLocked;
+    uint nBaudRate;         // locked rate, else the first candidate
+    uint nRatesTried;       // candidates listened to, including the locked one
+    uint32_t nTimeToLockMs; // from Run() to lock, or to giving up
+};
+
+// RX path accounting, all counts are since Run() was called
+struct GPSRxStats
+{
+    uint32_t nSentences;        // lines queued for parsing
+    uint32_t nUBXFrames;        // UBX frames queued for decoding
+    uint32_t nDroppedSentences; // lines lost to a full queue, overlength or DMA overrun
+    uint32_t nDroppedBytes;     // bytes of dropped or invalid lines
+    uint32_t nInvalid;          // lines failing format or checksum validation
+    uint32_t nHighWater;        // deepest the sentence queue has been
+    uint32_t nUBXHighWater;     // deepest the UBX frame queue has been
+};
 
 class GPS
 {
@@ -78,37 +268,112 @@ public:
     void SetSentenceCallback(void* pCtx, sentenceCallback pCB);
     void SetGpsDataCallback(void* pCtx, gpsDataCallback pCB);
     void Run();
+    // Switch a u-blox module currently at nCurrentBaud to NAV-PVT and
+    // NAV-SAT output in UBX only at nBaudRate, with a solution every
+    // nMeasRateMs, and follow it to the new baud rate.  This runs from Run()
+    // once the module is talking, checking each step for its ACK-ACK.
+    // NAV-SAT is several hundred bytes per epoch, so pick a rate the baud
+    // rate can carry.
+    void ConfigureUBX(uint nBaudRate, uint nCurrentBaud, uint nMeasRateMs = 1000);
+    // Negotiate baud rate, sentence mask and fix rate with a MediaTek
+    // module currently at nCurrentBaud.  This runs from Run() once the
+    // module is talking, falling back step by step if it does not confirm.
+    void ConfigurePMTK(const PMTKSettings& settings, uint nCurrentBaud);
+    // Detect the module's baud rate when Run() starts, before anything else
+    // is sent to it, by scoring each of GPS_AUTOBAUD_RATES on clean frames
+    void SetAutoBaud(bool bEnable)
+    {
+        m_bAutoBaud = bEnable;
+    }
+    // Valid once Run() is past detection
+    GPSAutoBaud GetAutoBaud() const
+    {
+        return m_autoBaud;
+    }
+    const PMTKConfig& GetPMTKConfig() const
+    {
+        return m_pmtkConfig;
+    }
+    const UBXConfig& GetUBXConfig() const
+    {
+        return m_ubxConfig;
+    }
+    void Stop()
+    {
+        m_bExit = true;
+    }
     uart_inst_t* GetUART()
     {
         return m_pUART0;
     }
+    GPSRxStats GetRxStats() const;
 
 private:
-    bool processSentence(std::string strSentence);
-    bool validateSentence(std::string& strSentence);
-    std::string checkSum(const std::string& strSentence);
-    std::string convertToDegrees(std::string strRaw, int width);
+#if defined(GPS_OLED_HOST_BUILD)
+    friend class GPSBench;
+#endif
+    bool processSentence(const NMEASentence& oSentence);
+    bool processUBX(const UBXFrame& oFrame);
 
     uart_inst_t* m_pUART0;
     uart_inst_t* m_pUART1; // output echo
 
-    // RX buffer management
-    static char sm_szBuffer[GPS_BUFSIZE];
-    static volatile size_t sm_iHead;
-    static volatile size_t sm_iNext;
-    static volatile size_t sm_nSentences;
-    static void on_uart_rx();
-    static bool getSentence(std::string& strSentence);
+    // RX buffer management.  A DMA channel paced by the UART DREQ writes
+    // into sm_szBuffer, which must be aligned to its size for ring wrap.
+    // A repeating timer drains the ring through the streaming parser into
+    // pre-split sentence slots for the Run() loop to handle in place.
+    // Ring positions are free-running byte counts, masked to index the ring.
+    alignas(GPS_BUFSIZE) static char sm_szBuffer[GPS_BUFSIZE];
+    void startRx();
+    void stopRx();
+    uint32_t rxWritten();
+    static bool onRxTimer(repeating_timer_t* pTimer);
+    void drainRx();
+    void dropRxSentence(uint32_t nBytes);
+    void rxUBX(uint8_t ch);
+    void autoBaud();
+    uint discardRx();
+
+    int m_nRxDMAChannel;
+    uint32_t m_nRxBase; // bytes written by previous DMA runs
+    uint32_t m_nRxScan; // next byte to move into a slot
+    repeating_timer_t m_rxTimer;
+    SPSCQueue<NMEASentence, GPS_SENTENCE_SLOTS> m_qSentences;
+    NMEASentence* m_pRxSlot; // slot being filled, if any
+    bool m_bRxDiscard;       // skipping to the end of a dropped line
+    NMEAParser m_rxParser;   // validates and splits the line being filled
+    SPSCQueue<UBXFrame, GPS_UBX_SLOTS> m_qUBXFrames;
+    UBXFrame* m_pRxUBXSlot;  // slot being filled, if any
+    bool m_bRxUBX;           // receiving a UBX frame rather than NMEA
+    UBXParser m_rxUBXParser;
+    UBXFrame m_rxUBXSkip;    // takes frames that find the queue full, so they are skipped by length
+    std::atomic<uint32_t> m_nRxSentences;
+    std::atomic<uint32_t> m_nRxUBXFrames;
+    std::atomic<uint32_t> m_nRxDroppedSentences;
+    std::atomic<uint32_t> m_nRxDroppedBytes;
+    std::atomic<uint32_t> m_nRxInvalid;
 
     // GPS object members
-    bool m_bExit;
+    std::atomic<bool> m_bExit;
+    bool m_bAutoBaud;
+    GPSAutoBaud m_autoBaud;
     bool m_bGSVInProgress;
-    std::string m_strNumGSV;
-    uint64_t m_nSatListTime;
+    uint m_nNumGSV;
+    uint m_nGSVPart;        // last part of the cycle in progress
+    uint8_t m_nGSVSystem;   // system and signal of the cycle in progress
+    uint8_t m_nGSVSignal;
+    uint8_t m_nSatCycle;    // stamps satellites reported by the cycle in progress
+    uint32_t m_nSatAgeTime; // ms timestamp of the last aging pass
     bool m_bSendGpsData;
-    GPSData::Shared m_spGPSData;
-    SatList m_mSatListIncoming;
-    SatList m_mSatListPersistent;
+    GPSData m_gpsData;
+    PMTKConfig m_pmtkConfig;
+    PMTKSettings m_settingsPMTK;
+    uint m_nPMTKBaud;
+    bool m_bPMTKPending; // ConfigurePMTK() called, waiting for the module
+    UBXConfig m_ubxConfig;
+    UBXSettings m_settingsUBX;
+    uint m_nUBXBaud;
+    bool m_bUBXPending; // ConfigureUBX() called, waiting for the module
 
     sentenceCallback m_pSentenceCallBack;
     void* m_pSentenceCtx;
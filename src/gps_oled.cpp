@@ -24,26 +24,34 @@
 
 #include <stdio.h>
 #include <string>
-#include <iostream>
+#include <string.h>
+#include <algorithm>
 #include <pico/double.h>
 #include <math.h>
-#include <iomanip>
 
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/uart.h"
+#if defined(GPS_OLED_DUAL_CORE)
+#include "pico/multicore.h"
+#endif
 
 #include "ssd1306.h"
 #include "gps_oled.h"
 #include "power_status.h"
 #include "font_factory.h"
+#include "fixed_format.h"
 
 #if !defined(NDEBUG)
 #include <malloc.h>
 static uint32_t getTotalHeap()
 {
+#if defined(GPS_OLED_HOST_BUILD)
+    return mallinfo().arena; // no fixed heap on the host, report what has been claimed
+#else
     extern char __StackLimit, __bss_end__;
     return &__StackLimit - &__bss_end__;
+#endif
 }
 static uint32_t getFreeHeap()
 {
@@ -54,13 +62,125 @@ static uint32_t getFreeHeap()
 
 #define SAT_ICON_RADIUS 2
 
+// Field formatters, integer only
+
+static void appendText(char* pszText, size_t nLen, const char* pszSuffix)
+{
+    size_t n = strlen(pszText);
+    while (*pszSuffix && n + 1 < nLen)
+    {
+        pszText[n++] = *pszSuffix++;
+    }
+    pszText[n] = '\0';
+}
+
+static void formatTwoDigits(char* pszText, uint nValue)
+{
+    pszText[0] = '0' + (nValue / 10) % 10;
+    pszText[1] = '0' + nValue % 10;
+}
+
+// nValue is fix mode, plus 0x100 if using an external antenna
+static void formatMode(char* pszText, size_t nLen, int32_t nValue)
+{
+    pszText[0] = '\0';
+    uint nMode = nValue & 0xff;
+    if (nMode >= 2)
+    {
+        format_fixed(pszText, nLen, nMode, 0, 0);
+        appendText(pszText, nLen, "D");
+    }
+    appendText(pszText, nLen, (nValue & 0x100) ? "*" : "");
+}
+
+// At least two digits, as GGA reports it, and more for multi-GNSS counts
+static void formatNumSats(char* pszText, size_t nLen, int32_t nValue)
+{
+    pszText[0] = '\0';
+    appendText(pszText, nLen, nValue < 10 ? "Sat: 0" : "Sat: ");
+    size_t n = strlen(pszText);
+    format_fixed(pszText + n, nLen - n, nValue, 0, 0);
+}
+
+static void formatLatitude(char* pszText, size_t nLen, int32_t nValue)
+{
+    format_fixed(pszText, nLen, nValue < 0 ? -nValue : nValue, 7, 4, 7);
+    appendText(pszText, nLen, nValue < 0 ? "S" : "N");
+}
+
+static void formatLongitude(char* pszText, size_t nLen, int32_t nValue)
+{
+    format_fixed(pszText, nLen, nValue < 0 ? -nValue : nValue, 7, 4, 8);
+    appendText(pszText, nLen, nValue < 0 ? "W" : "E");
+}
+
+// nValue in mm
+static void formatAltitude(char* pszText, size_t nLen, int32_t nValue)
+{
+    format_fixed(pszText, nLen, nValue, 3, (nValue > -1000000 && nValue < 1000000) ? 1 : 0);
+    appendText(pszText, nLen, "m");
+}
+
+// nValue in cm/s, tenths below 10 mph, each rounded once from the exact value
+static void formatSpeed(char* pszText, size_t nLen, int32_t nValue)
+{
+    uint64_t nMicroMph = (uint64_t)(uint32_t)nValue * 22369; // 1 cm/s = 0.022369 mph
+    if (nMicroMph < 10000000)
+    {
+        format_fixed(pszText, nLen, (nMicroMph + 50000) / 100000, 1, 1);
+    }
+    else
+    {
+        format_fixed(pszText, nLen, (nMicroMph + 500000) / 1000000, 0, 0);
+    }
+    appendText(pszText, nLen, "mph");
+}
+
+// nValue is hhmmss
+static void formatTime(char* pszText, size_t nLen, int32_t nValue)
+{
+    char szTime[] = "hh:mm:ssZ";
+    formatTwoDigits(szTime, nValue / 10000);
+    formatTwoDigits(szTime + 3, nValue / 100);
+    formatTwoDigits(szTime + 6, nValue);
+    pszText[0] = '\0';
+    appendText(pszText, nLen, szTime);
+}
+
+#if defined(VOLTAGE_DISPLAY)
+// nValue in cV, plus 0x10000 if on battery
+static void formatVoltage(char* pszText, size_t nLen, int32_t nValue)
+{
+    pszText[0] = '\0';
+    appendText(pszText, nLen, (nValue & 0x10000) ? "b:" : "");
+    size_t n = strlen(pszText);
+    format_fixed(pszText + n, nLen - n, nValue & 0xffff, 2, 1);
+    appendText(pszText, nLen, "V");
+}
+#endif
+
 constexpr double pi = 3.14159265359;
 
 GPS_OLED::GPS_OLED(SSD1306::Shared spDisplay, GPS::Shared spGPS, LED::Shared spLED, float GMToffset)
     : m_spDisplay(spDisplay),
       m_spGPS(spGPS),
       m_spLED(spLED),
-      m_GMToffset(GMToffset)
+      m_GMToffset(GMToffset),
+      m_ftMode(formatMode),
+      m_ftNumSats(formatNumSats),
+      m_ftLatitude(formatLatitude),
+      m_ftLongitude(formatLongitude),
+      m_ftAltitude(formatAltitude),
+      m_ftSpeed(formatSpeed),
+      m_ftTime(formatTime),
+#if defined(VOLTAGE_DISPLAY)
+      m_ftVoltage(formatVoltage),
+#endif
+      m_aSatIcons(),
+      m_nSatIconsVersion(0),
+      m_nSatIconsRadius(0),
+      m_pGPSData(nullptr),
+      m_nMaxLatency(0)
 {
 }
 
@@ -87,32 +207,70 @@ void GPS_OLED::Initialize()
 
 void GPS_OLED::Run()
 {
+#if defined(GPS_OLED_DUAL_CORE)
+    // Render and flush on core1 so UART intake on core0 never waits on the display
+    sm_pCore1 = this;
+    multicore_launch_core1(core1Entry);
+#endif
     m_spGPS->Run();
 }
 
-void GPS_OLED::sentenceCB(void* pCtx, std::string strSentence)
+#if defined(GPS_OLED_DUAL_CORE)
+GPS_OLED* GPS_OLED::sm_pCore1 = nullptr;
+
+void GPS_OLED::core1Entry()
+{
+    sm_pCore1->renderLoop();
+}
+
+void GPS_OLED::renderLoop()
 {
-    // printf("sentenceCB received: %s\n", strSentence.c_str());
+    while (true)
+    {
+        // Each FIFO word is a doorbell for a published snapshot; several may
+        // have been coalesced into the one we pick up.
+        multicore_fifo_pop_blocking();
+        if (m_tbGPSData.Acquire())
+        {
+            updateUI(m_tbGPSData.Front());
+        }
+    }
+}
+#endif
+
+void GPS_OLED::sentenceCB(void* pCtx, std::string_view svSentence)
+{
+    // printf("sentenceCB received: %.*s\n", (int)svSentence.size(), svSentence.data());
 }
 
-void GPS_OLED::gpsDataCB(void* pCtx, GPSData::Shared spGPSData)
+void GPS_OLED::gpsDataCB(void* pCtx, const GPSData& gpsData)
 {
     GPS_OLED* pThis = reinterpret_cast<GPS_OLED*>(pCtx);
-    pThis->updateUI(spGPSData);
+#if defined(GPS_OLED_DUAL_CORE)
+    // Snapshot for core1 and ring its doorbell, never blocking GPS intake
+    pThis->m_tbGPSData.Back() = gpsData;
+    pThis->m_tbGPSData.Publish();
+    if (multicore_fifo_wready())
+    {
+        multicore_fifo_push_blocking(0);
+    }
+#else
+    pThis->updateUI(gpsData);
+#endif
 }
 
-void GPS_OLED::updateUI(GPSData::Shared spGPSData)
+void GPS_OLED::updateUI(const GPSData& gpsData)
 {
-    m_spGPSData = spGPSData;
+    m_pGPSData = &gpsData;
     if (m_spLED)
     {
-        if (m_spGPSData->bHasPosition)
+        if (gpsData.bHasPosition)
         {
-            m_spLED->SetPixel(0, m_spGPSData->bExternalAntenna ? led_blue : led_green);
+            m_spLED->SetPixel(0, gpsData.bExternalAntenna ? led_blue : led_green);
         }
         else
         {
-            m_spLED->SetPixel(0, m_spGPSData->bExternalAntenna ? led_magenta : led_red);
+            m_spLED->SetPixel(0, gpsData.bExternalAntenna ? led_magenta : led_red);
         }
         m_spLED->Blink_ms(20);
     }
@@ -126,58 +284,70 @@ void GPS_OLED::updateUI(GPSData::Shared spGPSData)
     uint X_PAD = PAD_CHARS_X * getCharWidth();
     // uint Y_PAD = PAD_CHARS_Y * (getCharHeight() + 1);
 
-#if defined(VOLTAGE_DISPLAY)
-    float vsys    = 0.0;
-    bool bBattery = false;
-    std::string strVsys;
-    if (PICO_OK == power_voltage(&vsys))
-    {
-        power_source(&bBattery);
-        vsys = floorf(vsys * 100) / 100;
-        std::stringstream oss;
-        oss << (bBattery ? "b:" : "") << std::fixed << std::setfill(' ') << std::setprecision(1) << vsys << "V";
-        strVsys = oss.str();
-    }
-#endif
-
     m_spDisplay->Fill(COLOUR_BLACK);
 
     // Draw satellite grid
     drawSatGrid(nWidth / 4, nHeight / 2, nHeight / 2 - getCharHeight() / 2, 2);
 
-    // Draw fix and #sats text
-    drawText(0, spGPSData->strMode3D + (m_spGPSData->bExternalAntenna ? "*" : ""), COLOUR_WHITE, false, X_PAD);
-    drawText(3, spGPSData->strNumSats, COLOUR_WHITE, true, X_PAD);
+    // Draw fix and #sats text, formatting only what is drawn
+    drawText(0, m_ftMode.Get(gpsData.nFixMode | (gpsData.bExternalAntenna ? 0x100 : 0)), COLOUR_WHITE, false, X_PAD);
+    if (gpsData.nNumSats >= 0)
+    {
+        drawText(3, m_ftNumSats.Get(gpsData.nNumSats), COLOUR_WHITE, true, X_PAD);
+    }
 
-    if (!spGPSData->strLatitude.empty())
+    if (gpsData.bHasLatLon)
     {
-        drawText(0, spGPSData->strLatitude, COLOUR_WHITE, true, X_PAD);
-        drawText(1, spGPSData->strLongitude, COLOUR_WHITE, true, X_PAD);
-        drawText(2, spGPSData->strAltitude, COLOUR_WHITE, true, X_PAD);
-        if (getCharHeight() <= 12) // only if room
+        drawText(0, m_ftLatitude.Get(gpsData.nLatitude), COLOUR_WHITE, true, X_PAD);
+        drawText(1, m_ftLongitude.Get(gpsData.nLongitude), COLOUR_WHITE, true, X_PAD);
+        if (gpsData.bHasAltitude)
+        {
+            drawText(2, m_ftAltitude.Get(gpsData.nAltitude), COLOUR_WHITE, true, X_PAD);
+        }
+        if (gpsData.bHasSpeed && getCharHeight() <= 12) // only if room
         {
-            drawText(4, spGPSData->strSpeed, COLOUR_WHITE, true, X_PAD);
+            drawText(4, m_ftSpeed.Get(gpsData.nSpeed), COLOUR_WHITE, true, X_PAD);
         }
     }
-    if (!spGPSData->strGPSTime.empty())
+    if (gpsData.bHasTime)
     {
-        drawText(-1, spGPSData->strGPSTime, COLOUR_WHITE, true, X_PAD);
+        drawText(-1, m_ftTime.Get(gpsData.nUTCTime), COLOUR_WHITE, true, X_PAD);
     }
 
 #if defined(VOLTAGE_DISPLAY)
-    if (!strVsys.empty() && getCharHeight() <= 8) // only if room
+    float vsys    = 0.0;
+    bool bBattery = false;
+    if (getCharHeight() <= 8 && PICO_OK == power_voltage(&vsys)) // only if room
     {
-        drawText(-2, strVsys, COLOUR_WHITE, true, X_PAD);
+        power_source(&bBattery);
+        drawText(-2, m_ftVoltage.Get((int32_t)(vsys * 100) | (bBattery ? 0x10000 : 0)), COLOUR_WHITE, true, X_PAD);
     }
 #endif
 
     // blit the framebuf to the display
     m_spDisplay->Show();
 
-    m_spGPSData.reset();
+    m_pGPSData = nullptr;
+
+    uint32_t nLatency = time_us_64() - gpsData.nTimestamp;
+    m_nMaxLatency     = std::max(m_nMaxLatency, nLatency);
 
 #if !defined(NDEBUG)
+    printf("Parse to pixel: %u us  max: %u us\n", nLatency, m_nMaxLatency);
     printf("Total Heap: %d  Free Heap: %d\n", getTotalHeap(), getFreeHeap());
+    GPSRxStats rxStats = m_spGPS->GetRxStats();
+    printf("RX sentences: %u  invalid: %u  dropped: %u (%u bytes)  queue high water: %u\n",
+           rxStats.nSentences,
+           rxStats.nInvalid,
+           rxStats.nDroppedSentences,
+           rxStats.nDroppedBytes,
+           rxStats.nHighWater);
+    const SSD1306Stats& dispStats = m_spDisplay->GetStats();
+    printf("Display: %u bytes  %u transactions  windows: %u  mean: %u bytes/frame\n",
+           dispStats.nLastBytes,
+           dispStats.nLastTransactions,
+           dispStats.nWindows,
+           dispStats.nFrames ? dispStats.nDataBytes / dispStats.nFrames : 0);
 #endif
 }
 
@@ -196,41 +366,41 @@ void GPS_OLED::drawSatGrid(uint xCenter, uint yCenter, uint radius, uint nRings)
     // m_spDisplay->Text("`", xCenter - 2, yCenter - radius - getCharHeight() / 2, COLOUR_RED);
 
     int satRadius = SAT_ICON_RADIUS / 2;
-    if (!m_spGPSData->strLatitude.empty())
+    if (m_pGPSData->bHasLatLon)
     {
         satRadius = SAT_ICON_RADIUS;
     }
-    for (auto oEntry : m_spGPSData->mSatList)
+    const SatList& satList = m_pGPSData->mSatList;
+    bool bPlaced           = satList.Version() == m_nSatIconsVersion && radius == m_nSatIconsRadius;
+    SatIcon* pIcon         = m_aSatIcons;
+    for (const auto& oSat : satList)
     {
-        auto oSat    = oEntry.second;
-        double elrad = oSat.m_el * pi / 180;
-        double azrad = oSat.m_az * pi / 180;
-        drawCircleSat(xCenter, yCenter, radius, elrad, azrad, satRadius, COLOUR_WHITE, COLOUR_BLACK);
-        for (auto nSat : m_spGPSData->vUsedList)
+        if (!bPlaced && (radius != m_nSatIconsRadius || pIcon->nKey != oSat.Key() || pIcon->nVersion != oSat.m_nVersion))
+        {
+            float elrad     = oSat.m_el * pi / 180;
+            float azrad     = oSat.m_az * pi / 180;
+            pIcon->nKey     = oSat.Key();
+            pIcon->nVersion = oSat.m_nVersion;
+            pIcon->dx       = (radius - SAT_ICON_RADIUS) * cos(elrad) * sin(azrad);
+            pIcon->dy       = (radius - SAT_ICON_RADIUS) * cos(elrad) * -cos(azrad);
+        }
+        int x = xCenter + pIcon->dx;
+        int y = yCenter + pIcon->dy;
+        ++pIcon;
+
+        drawCircleSat(x, y, satRadius, COLOUR_WHITE, COLOUR_BLACK);
+        if (m_pGPSData->IsUsed(oSat))
         {
-            if (oSat.m_num == nSat)
-            {
-                drawCircleSat(xCenter, yCenter, radius, elrad, azrad, satRadius, COLOUR_WHITE, COLOUR_BLUE);
-                break;
-            }
+            drawCircleSat(x, y, satRadius, COLOUR_WHITE, COLOUR_BLUE);
         }
     }
+    m_nSatIconsVersion = satList.Version();
+    m_nSatIconsRadius  = radius;
 }
 
-void GPS_OLED::drawCircleSat(uint gridCenterX,
-                             uint gridCenterY,
-                             uint nGridRadius,
-                             float elrad,
-                             float azrad,
-                             uint satRadius,
-                             uint16_t color,
-                             uint16_t fillColor)
+void GPS_OLED::drawCircleSat(int x, int y, uint satRadius, uint16_t color, uint16_t fillColor)
 {
     // Draw satellite (fill first, then draw open circle)
-    int dx = (nGridRadius - SAT_ICON_RADIUS) * cos(elrad) * sin(azrad);
-    int dy = (nGridRadius - SAT_ICON_RADIUS) * cos(elrad) * -cos(azrad);
-    int x  = gridCenterX + dx;
-    int y  = gridCenterY + dy;
     m_spDisplay->Ellipse(x, y, satRadius, satRadius, fillColor, true); // Clear area with fill
     m_spDisplay->Ellipse(x, y, satRadius, satRadius, color);           // Draw circle without fill
 }
@@ -243,10 +413,10 @@ int GPS_OLED::linePos(int nLine)
         return m_spDisplay->Height() + (nLine * getLineAdvance());
 }
 
-void GPS_OLED::drawText(int nLine, std::string strText, uint16_t color, bool bRightAlign, uint nRightPad)
+void GPS_OLED::drawText(int nLine, const char* pszText, uint16_t color, bool bRightAlign, uint nRightPad)
 {
-    int x = (!bRightAlign) ? 0 : m_spDisplay->Width() - (strText.length() * getCharWidth());
+    int x = (!bRightAlign) ? 0 : m_spDisplay->Width() - (strlen(pszText) * getCharWidth());
     int y = linePos(nLine);
     x     = x - nRightPad;
-    m_spDisplay->Text(strText.c_str(), x, y, color);
+    m_spDisplay->Text(pszText, x, y, color);
 }
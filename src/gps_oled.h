@@ -18,6 +18,43 @@
 #include "gps.h"
 #include "led.h"
 #include "font.h"
+#include "triple_buffer.h"
+
+// FieldText
+//
+// Display text for one numeric field, regenerated only when its value
+// changes so unchanged fields cost a compare per frame.
+//
+class FieldText
+{
+public:
+    typedef void (*formatter)(char* pszText, size_t nLen, int32_t nValue);
+
+    FieldText(formatter pFormat)
+        : m_pFormat(pFormat),
+          m_bValid(false),
+          m_nValue(0),
+          m_szText()
+    {
+    }
+
+    const char* Get(int32_t nValue)
+    {
+        if (!m_bValid || nValue != m_nValue)
+        {
+            (*m_pFormat)(m_szText, sizeof(m_szText), nValue);
+            m_nValue = nValue;
+            m_bValid = true;
+        }
+        return m_szText;
+    }
+
+private:
+    formatter m_pFormat;
+    bool m_bValid;
+    int32_t m_nValue;
+    char m_szText[20];
+};
 
 // GPS_OLED class
 //
@@ -39,23 +76,24 @@ public:
     void Run();
 
 private:
-    static void sentenceCB(void* pCtx, std::string strSentence);
-    static void gpsDataCB(void* pCtx, GPSData::Shared spGPSData);
+#if defined(GPS_OLED_HOST_BUILD)
+    friend class GPSBench;
+#endif
+    static void sentenceCB(void* pCtx, std::string_view svSentence);
+    static void gpsDataCB(void* pCtx, const GPSData& gpsData);
+#if defined(GPS_OLED_DUAL_CORE)
+    static void core1Entry();
+    static GPS_OLED* sm_pCore1; // instance rendered by core1, pointers do not fit a FIFO word on every host
+    void renderLoop();
+#endif
 
-    void updateUI(GPSData::Shared spGPSData);
+    void updateUI(const GPSData& gpsData);
     void drawSatGrid(uint xCenter, uint yCenter, uint radius, uint nRings = 3);
     void drawBarGraph(uint x, uint y, uint width, uint height);
     void drawClock(uint x, uint y, uint radius, std::string strTime);
-    void drawCircleSat(uint gridCenterX,
-                       uint gridCenterY,
-                       uint nGridRadius,
-                       float elrad,
-                       float azrad,
-                       uint satRadius,
-                       uint16_t color     = COLOUR_WHITE,
-                       uint16_t fillColor = COLOUR_WHITE);
+    void drawCircleSat(int x, int y, uint satRadius, uint16_t color = COLOUR_WHITE, uint16_t fillColor = COLOUR_WHITE);
     int linePos(int nLine);
-    void drawText(int nLine, std::string strText, uint16_t color = COLOUR_WHITE, bool bRightAlign = true, uint nPadding = 0);
+    void drawText(int nLine, const char* pszText, uint16_t color = COLOUR_WHITE, bool bRightAlign = true, uint nPadding = 0);
 
     // Font management - delegates to m_spDisplay
     void SetFont(const BitmapFont* pFont)
@@ -90,5 +128,36 @@ private:
     LED::Shared m_spLED;
     float m_GMToffset;
 
-    GPSData::Shared m_spGPSData;
+    // Cached field text
+    FieldText m_ftMode;
+    FieldText m_ftNumSats;
+    FieldText m_ftLatitude;
+    FieldText m_ftLongitude;
+    FieldText m_ftAltitude;
+    FieldText m_ftSpeed;
+    FieldText m_ftTime;
+#if defined(VOLTAGE_DISPLAY)
+    FieldText m_ftVoltage;
+#endif
+
+    // Satellite icon offsets from the grid centre.  Trigonometry is only
+    // redone for satellites whose SatInfo version moved since they were
+    // placed, and not at all while the list version is unchanged.
+    struct SatIcon
+    {
+        uint32_t nKey;
+        uint32_t nVersion;
+        int16_t dx;
+        int16_t dy;
+    };
+    SatIcon m_aSatIcons[GPS_MAX_SATS];
+    uint32_t m_nSatIconsVersion; // SatList::Version() the icons were placed from
+    uint m_nSatIconsRadius;      // grid radius they were placed for, 0 for never
+
+    const GPSData* m_pGPSData; // valid during updateUI
+    uint32_t m_nMaxLatency;    // worst parse-to-pixel time seen, us
+
+#if defined(GPS_OLED_DUAL_CORE)
+    TripleBuffer<GPSData> m_tbGPSData; // core0 publishes, core1 renders
+#endif
 };
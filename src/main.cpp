@@ -46,6 +46,10 @@
 #define STOP_BITS      1
 #define PARITY         UART_PARITY_NONE
 
+// #define USE_UBX_BAUD_RATE 115200  // Switch a u-blox module to binary NAV-PVT/NAV-SAT at this rate
+// #define USE_AUTOBAUD              // Detect the module's baud rate at startup from GPS_AUTOBAUD_RATES
+// #define USE_PMTK_BAUD_RATE 115200 // Switch a MediaTek module to 10 Hz GGA/RMC/GSA (GSV at 2 Hz) at this rate
+
 #if defined(WAVESHARE_RP2040_ZERO)
 #define I2C_DEVICE i2c1
 #define PIN_SDA    2
@@ -56,6 +60,19 @@
 #define PIN_SCL    PICO_DEFAULT_I2C_SCL_PIN
 #endif
 
+// #define USE_ASYNC_DISPLAY // Queue display frames to DMA rather than blocking in Show() (untested on hardware)
+
+// #define USE_SPI_DISPLAY // Drive a 4-wire SPI OLED module instead of I2C
+#if defined(USE_SPI_DISPLAY)
+#define SPI_DEVICE    spi_default
+#define SPI_BAUD_RATE (10 * 1000 * 1000)
+#define PIN_SCK       PICO_DEFAULT_SPI_SCK_PIN
+#define PIN_MOSI      PICO_DEFAULT_SPI_TX_PIN
+#define PIN_CS        PICO_DEFAULT_SPI_CSN_PIN
+#define PIN_DC        20
+#define PIN_RST       21
+#endif
+
 // #define USE_WS2812_PIN 12 // Override
 // #define USE_LED_PIN 16    // Override
 
@@ -97,11 +114,17 @@ int main()
 #endif
 
     // Set up the OLED display
+#if defined(USE_SPI_DISPLAY)
+    spi_init(SPI_DEVICE, SPI_BAUD_RATE);
+    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
+    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
+#else
     i2c_init(I2C_DEVICE, 400 * 1000);
     gpio_set_function(PIN_SDA, GPIO_FUNC_I2C);
     gpio_set_function(PIN_SCL, GPIO_FUNC_I2C);
     gpio_pull_up(PIN_SDA);
     gpio_pull_up(PIN_SCL);
+#endif
 
 #if defined(SEEED_XIAO_RP2040)
     // Clear LED(s) on XIAO (default on)
@@ -142,8 +165,32 @@ int main()
     GPS::Shared spGPS = std::make_shared<GPS>(UART0_DEVICE);
 #endif
 
+#if defined(USE_AUTOBAUD)
+    spGPS->SetAutoBaud(true);
+#endif
+#if defined(USE_PMTK_BAUD_RATE)
+    PMTKSettings settingsPMTK = {USE_PMTK_BAUD_RATE, 100, pmtk_mask(kPMTKGGA) | pmtk_mask(kPMTKRMC) | pmtk_mask(kPMTKGSA) | pmtk_mask(kPMTKGSV), 5};
+    spGPS->ConfigurePMTK(settingsPMTK, UART_BAUD_RATE);
+#if defined(UART1_DEVICE)
+    uart_set_baudrate(UART1_DEVICE, USE_PMTK_BAUD_RATE); // keep up with the echo
+#endif
+#elif defined(USE_UBX_BAUD_RATE)
+    spGPS->ConfigureUBX(USE_UBX_BAUD_RATE, UART_BAUD_RATE);
+#if defined(UART1_DEVICE)
+    uart_set_baudrate(UART1_DEVICE, USE_UBX_BAUD_RATE); // keep up with the echo
+#endif
+#endif
+
     // Create the display
-    SSD1306::Shared spDisplay = std::make_shared<SSD1306_I2C>(128, 64, I2C_DEVICE);
+#if defined(USE_SPI_DISPLAY)
+    SSD1306::Shared spDisplay = std::make_shared<SSD1306_SPI>(128, 64, SPI_DEVICE, PIN_DC, PIN_CS, PIN_RST);
+#else
+    std::shared_ptr<SSD1306_I2C> spI2CDisplay = std::make_shared<SSD1306_I2C>(128, 64, I2C_DEVICE);
+#if defined(USE_ASYNC_DISPLAY)
+    spI2CDisplay->SetAsync(true);
+#endif
+    SSD1306::Shared spDisplay = spI2CDisplay;
+#endif
 
     // Create the GPS_OLED display object
     GPS_OLED::Shared spDevice = std::make_shared<GPS_OLED>(spDisplay, spGPS, spLED, GPSD_GMT_OFFSET);
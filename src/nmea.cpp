@@ -0,0 +1,398 @@
+/*
+ * NMEA sentence helpers
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "nmea.h"
+
+// Hex digit values, 0xff for anything else
+static constexpr struct HexTable
+{
+    uint8_t aValue[256];
+    constexpr HexTable()
+        : aValue()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            aValue[i] = 0xff;
+        }
+        for (int i = 0; i < 10; ++i)
+        {
+            aValue['0' + i] = i;
+        }
+        for (int i = 0; i < 6; ++i)
+        {
+            aValue['A' + i] = 10 + i;
+            aValue['a' + i] = 10 + i;
+        }
+    }
+} sg_hexTable;
+
+NMEAChecksum::eState NMEAChecksum::Feed(char c)
+{
+    uint8_t nNibble;
+    switch (m_eState)
+    {
+    case kStart:
+        m_eState = (c == '$') ? kBody : kBad;
+        ++m_nPayloadLen;
+        break;
+    case kBody:
+        if (c == '*')
+        {
+            m_eState = kCheckHi;
+        }
+        else if (c == '\r' || c == '\n' || c == '$' || m_nPayloadLen == UINT16_MAX)
+        {
+            // '$' only starts a sentence, mid-line it means this one was cut short
+            m_eState = kBad;
+        }
+        else
+        {
+            m_nSum ^= (uint8_t)c;
+            ++m_nPayloadLen;
+        }
+        break;
+    case kCheckHi:
+        nNibble     = sg_hexTable.aValue[(uint8_t)c];
+        m_nExpected = nNibble << 4;
+        m_eState    = (nNibble == 0xff) ? kBad : kCheckLo;
+        break;
+    case kCheckLo:
+        nNibble = sg_hexTable.aValue[(uint8_t)c];
+        m_nExpected |= nNibble;
+        m_eState = (nNibble == 0xff || m_nExpected != m_nSum) ? kBad : kCR;
+        break;
+    case kCR:
+        m_eState = (c == '\r') ? kLF : kBad;
+        break;
+    case kLF:
+        m_eState = (c == '\n') ? kValid : kBad;
+        break;
+    default:
+        m_eState = kBad; // nothing may follow a complete line
+        break;
+    }
+    return m_eState;
+}
+
+bool nmea_validate(std::string_view svLine, std::string_view& svPayload)
+{
+    NMEAChecksum check;
+    for (char c : svLine)
+    {
+        if (check.Feed(c) == NMEAChecksum::kBad)
+        {
+            return false;
+        }
+    }
+    if (check.State() != NMEAChecksum::kValid)
+    {
+        return false;
+    }
+    svPayload = svLine.substr(0, check.PayloadLen());
+    return true;
+}
+
+void NMEAParser::Begin(NMEASentence* pSentence)
+{
+    m_pSentence                 = pSentence;
+    m_pSentence->eType          = kUnknownSentence;
+    m_pSentence->eTalkerId      = kTalkerUnknown;
+    m_pSentence->nLen           = 0;
+    m_pSentence->nPayloadLen    = 0;
+    m_pSentence->nFields        = 1;
+    m_pSentence->aFieldStart[0] = 0;
+    m_check.Reset();
+}
+
+NMEAParser::eResult NMEAParser::Feed(char c)
+{
+    NMEASentence& oSentence = *m_pSentence;
+    if (oSentence.nLen == NMEA_MAX_SENTENCE)
+    {
+        return kOverlength;
+    }
+    oSentence.szData[oSentence.nLen++] = c;
+
+    switch (m_check.Feed(c))
+    {
+    case NMEAChecksum::kBody:
+        if (c == ',')
+        {
+            if (oSentence.nFields == NMEA_MAX_FIELDS)
+            {
+                return kBad;
+            }
+            oSentence.aFieldStart[oSentence.nFields++] = oSentence.nLen;
+        }
+        return kPending;
+    case NMEAChecksum::kValid:
+        oSentence.nPayloadLen = m_check.PayloadLen();
+        oSentence.eType       = nmea_sentence_type(oSentence[0], oSentence.eTalkerId);
+        return kSentence;
+    case NMEAChecksum::kBad:
+        return kBad;
+    default:
+        return kPending;
+    }
+}
+
+eSentenceType nmea_sentence_type(std::string_view svHeader, eTalker& eTalkerId)
+{
+    eTalkerId = kTalkerUnknown;
+    if (svHeader.size() < 4 || svHeader[0] != '$')
+    {
+        return kUnknownSentence;
+    }
+
+    if (svHeader[1] == 'P')
+    {
+        eTalkerId = kTalkerProprietary;
+        if (svHeader.substr(2, 3) == "MTK")
+        {
+            return kPMTK;
+        }
+        switch (nmea_key(svHeader.substr(2)))
+        {
+        case nmea_key("GTOP"):
+            return kPGTOP;
+        case nmea_key("CD"):
+            return svHeader.size() == 4 ? kPCD : kUnknownSentence;
+        default:
+            return kUnknownSentence;
+        }
+    }
+
+    if (svHeader.size() != 6)
+    {
+        return kUnknownSentence;
+    }
+
+    switch (nmea_key(svHeader.substr(1, 2)))
+    {
+    case nmea_key("GP"):
+        eTalkerId = kTalkerGP;
+        break;
+    case nmea_key("GN"):
+        eTalkerId = kTalkerGN;
+        break;
+    case nmea_key("GL"):
+        eTalkerId = kTalkerGL;
+        break;
+    case nmea_key("GA"):
+        eTalkerId = kTalkerGA;
+        break;
+    case nmea_key("GB"):
+        eTalkerId = kTalkerGB;
+        break;
+    case nmea_key("BD"):
+        eTalkerId = kTalkerBD;
+        break;
+    case nmea_key("GQ"):
+        eTalkerId = kTalkerGQ;
+        break;
+    case nmea_key("GI"):
+        eTalkerId = kTalkerGI;
+        break;
+    default:
+        return kUnknownSentence;
+    }
+
+    switch (nmea_key(svHeader.substr(3)))
+    {
+    case nmea_key("GGA"):
+        return kGGA;
+    case nmea_key("GSA"):
+        return kGSA;
+    case nmea_key("GSV"):
+        return kGSV;
+    case nmea_key("RMC"):
+        return kRMC;
+    case nmea_key("VTG"):
+        return kVTG;
+    default:
+        return kUnknownSentence;
+    }
+}
+
+eGNSSystem nmea_talker_system(eTalker eTalkerId)
+{
+    switch (eTalkerId)
+    {
+    case kTalkerGP:
+        return kSystemGPS;
+    case kTalkerGL:
+        return kSystemGLONASS;
+    case kTalkerGA:
+        return kSystemGalileo;
+    case kTalkerGB:
+    case kTalkerBD:
+        return kSystemBeiDou;
+    case kTalkerGQ:
+        return kSystemQZSS;
+    case kTalkerGI:
+        return kSystemNavIC;
+    default:
+        return kSystemUnknown;
+    }
+}
+
+eGNSSystem nmea_prn_system(uint32_t nPRN)
+{
+    if (nPRN >= 1 && nPRN <= 64)
+    {
+        return kSystemGPS; // GPS 1-32, SBAS 33-64
+    }
+    if (nPRN >= 65 && nPRN <= 96)
+    {
+        return kSystemGLONASS;
+    }
+    if (nPRN >= 193 && nPRN <= 202)
+    {
+        return kSystemQZSS;
+    }
+    if (nPRN >= 301 && nPRN <= 336)
+    {
+        return kSystemGalileo;
+    }
+    if (nPRN >= 401 && nPRN <= 437)
+    {
+        return kSystemBeiDou;
+    }
+    return kSystemUnknown;
+}
+
+uint32_t nmea_to_uint(std::string_view svField)
+{
+    uint32_t nValue = 0;
+    for (char c : svField)
+    {
+        if (c < '0' || c > '9')
+        {
+            break;
+        }
+        nValue = nValue * 10 + (c - '0');
+    }
+    return nValue;
+}
+
+uint32_t nmea_hex_to_uint(std::string_view svField)
+{
+    uint32_t nValue = 0;
+    for (char c : svField)
+    {
+        uint8_t nNibble = sg_hexTable.aValue[(uint8_t)c];
+        if (nNibble == 0xff)
+        {
+            break;
+        }
+        nValue = (nValue << 4) | nNibble;
+    }
+    return nValue;
+}
+
+int32_t nmea_to_fixed(std::string_view svField, uint32_t nDecimals)
+{
+    bool bNegative = !svField.empty() && svField[0] == '-';
+    if (bNegative)
+    {
+        svField.remove_prefix(1);
+    }
+    int32_t nValue = 0;
+    bool bFraction = false;
+    for (char c : svField)
+    {
+        if (c == '.' && !bFraction)
+        {
+            bFraction = true;
+            continue;
+        }
+        if (c < '0' || c > '9' || (bFraction && 0 == nDecimals))
+        {
+            break;
+        }
+        nValue = nValue * 10 + (c - '0');
+        if (bFraction)
+        {
+            --nDecimals;
+        }
+    }
+    while (nDecimals--)
+    {
+        nValue *= 10;
+    }
+    return bNegative ? -nValue : nValue;
+}
+
+bool nmea_to_degrees(std::string_view svField, int32_t& nDegrees, uint32_t nMaxDegrees)
+{
+    nMaxDegrees = std::min<uint32_t>(nMaxDegrees, 180); // no coordinate goes further, and the result fits in 31 bits
+
+    // Whole degrees and minutes, i.e. DDDMM
+    uint32_t nWhole = 0;
+    size_t i        = 0;
+    for (; i < svField.size() && svField[i] != '.'; ++i)
+    {
+        if (svField[i] < '0' || svField[i] > '9' || i >= 5)
+        {
+            return false;
+        }
+        nWhole = nWhole * 10 + (svField[i] - '0');
+    }
+    if (i < 3 || nWhole / 100 > nMaxDegrees)
+    {
+        return false;
+    }
+
+    // Minutes in 1e-7 units, at most 599999999 so it fits in 32 bits.  Any
+    // fraction digits beyond the seventh are below the output resolution.
+    uint32_t nMinutes = nWhole % 100;
+    uint32_t nDigits  = 0;
+    for (++i; i < svField.size() && nDigits < 7; ++i, ++nDigits)
+    {
+        if (svField[i] < '0' || svField[i] > '9')
+        {
+            return false;
+        }
+        nMinutes = nMinutes * 10 + (svField[i] - '0');
+    }
+    for (; nDigits < 7; ++nDigits)
+    {
+        nMinutes *= 10;
+    }
+    if (nMinutes >= 600000000)
+    {
+        return false;
+    }
+
+    // 1e-7 degrees = 1e-7 minutes / 60
+    uint32_t nResult = (nWhole / 100) * 10000000 + (nMinutes + 30) / 60;
+    if (nResult > nMaxDegrees * 10000000)
+    {
+        return false;
+    }
+    nDegrees = nResult;
+    return true;
+}
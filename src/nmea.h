@@ -0,0 +1,218 @@
+/*
+ * NMEA sentence helpers
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+auto constexpr NMEA_MAX_FIELDS   = 24;  // GSV with signal ID is 21 fields, leave room for proprietary
+auto constexpr NMEA_MAX_SENTENCE = 128; // Longer lines are discarded, must fit field offsets
+
+typedef enum eSentenceType
+{
+    kGGA,
+    kGSA,
+    kGSV,
+    kRMC,
+    kVTG,
+    kPGTOP,
+    kPCD,
+    kPMTK,
+    kUnknownSentence,
+} eSentenceType;
+
+typedef enum eTalker
+{
+    kTalkerGP, // GPS
+    kTalkerGN, // Combined GNSS
+    kTalkerGL, // GLONASS
+    kTalkerGA, // Galileo
+    kTalkerGB, // BeiDou
+    kTalkerBD, // BeiDou (older receivers)
+    kTalkerGQ, // QZSS
+    kTalkerGI, // NavIC
+    kTalkerProprietary,
+    kTalkerUnknown,
+} eTalker;
+
+// NMEA 4.10 GNSS system IDs, as carried in the GSA system ID field
+typedef enum eGNSSystem
+{
+    kSystemUnknown = 0,
+    kSystemGPS     = 1, // including SBAS
+    kSystemGLONASS = 2,
+    kSystemGalileo = 3,
+    kSystemBeiDou  = 4,
+    kSystemQZSS    = 5,
+    kSystemNavIC   = 6,
+    kNumSystems,
+} eGNSSystem;
+
+// NMEAChecksum
+//
+// Incremental validator for one "$...*HH\r\n" line.  Bytes are fed as they
+// arrive, the XOR is accumulated on the fly and the hex digits are decoded by
+// table lookup, so a line is accepted or rejected in a single pass with no
+// copies.  Once kBad is reported the rest of the line can be skipped.
+//
+class NMEAChecksum
+{
+public:
+    typedef enum eState
+    {
+        kStart,   // expecting '$'
+        kBody,    // accumulating up to '*'
+        kCheckHi, // first hex digit
+        kCheckLo, // second hex digit
+        kCR,
+        kLF,
+        kValid, // complete, checksum matched
+        kBad,   // malformed or checksum mismatch
+    } eState;
+
+    NMEAChecksum()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        m_eState      = kStart;
+        m_nSum        = 0;
+        m_nExpected   = 0;
+        m_nPayloadLen = 0;
+    }
+
+    eState Feed(char c);
+
+    eState State() const
+    {
+        return m_eState;
+    }
+    // Length of "$..." up to but not including '*', valid once kValid
+    uint16_t PayloadLen() const
+    {
+        return m_nPayloadLen;
+    }
+
+private:
+    eState m_eState;
+    uint8_t m_nSum;
+    uint8_t m_nExpected;
+    uint16_t m_nPayloadLen;
+};
+
+// Validate a complete line in one pass, returning the "$..." payload
+bool nmea_validate(std::string_view svLine, std::string_view& svPayload);
+
+// Pack up to four characters into an integer so that sentence headers can be
+// compared with a single word compare and used as switch labels.
+constexpr uint32_t nmea_key(std::string_view sv)
+{
+    uint32_t nKey = 0;
+    for (size_t i = 0; i < sv.size() && i < 4; ++i)
+    {
+        nKey = (nKey << 8) | (uint8_t)sv[i];
+    }
+    return nKey;
+}
+
+// Decode a "$TTSSS" (or "$Pxxxx" proprietary) header field
+eSentenceType nmea_sentence_type(std::string_view svHeader, eTalker& eTalkerId);
+
+// NMEASentence
+//
+// One received line, including the trailing "*HH\r\n", with its header
+// decoded and the field boundaries recorded as it was parsed.  Fields are
+// views into szData, so no copies are made and nothing needs splitting
+// later.  Indexing past the last field returns an empty view rather than
+// faulting, as receivers often omit trailing empty fields.
+//
+struct NMEASentence
+{
+    eSentenceType eType;
+    eTalker eTalkerId;
+    uint16_t nLen;        // bytes in szData
+    uint16_t nPayloadLen; // "$..." up to the '*'
+    uint8_t nFields;
+    uint64_t nTimestamp;                  // time_us_64() when the RX path completed it
+    uint8_t aFieldStart[NMEA_MAX_FIELDS]; // offset of each field in szData
+    char szData[NMEA_MAX_SENTENCE];
+
+    size_t size() const
+    {
+        return nFields;
+    }
+    std::string_view Payload() const
+    {
+        return std::string_view(szData, nPayloadLen);
+    }
+    std::string_view operator[](size_t i) const
+    {
+        if (i >= nFields)
+        {
+            return std::string_view();
+        }
+        size_t nEnd = (i + 1 < nFields) ? aFieldStart[i + 1] - 1u : nPayloadLen;
+        return std::string_view(szData + aFieldStart[i], nEnd - aFieldStart[i]);
+    }
+};
+
+static_assert(NMEA_MAX_SENTENCE <= 256, "field offsets are 8 bits");
+
+// NMEAParser
+//
+// Streaming parser that consumes one byte at a time, from an ISR, a DMA
+// chunk or a replay file, straight into the caller's NMEASentence.  The
+// checksum and the field boundaries are tracked as bytes arrive, and the
+// header is decoded once the terminator is seen, so a line is touched
+// exactly once between the UART and the sentence handlers.
+//
+class NMEAParser
+{
+public:
+    typedef enum eResult
+    {
+        kPending,    // need more bytes
+        kSentence,   // the target holds a complete, valid sentence
+        kBad,        // malformed, bad checksum or too many fields
+        kOverlength, // longer than NMEA_MAX_SENTENCE
+    } eResult;
+
+    NMEAParser()
+        : m_pSentence(nullptr)
+    {
+    }
+
+    // Start a new line in pSentence, which must stay valid until the next Begin()
+    void Begin(NMEASentence* pSentence);
+    // Only call after Begin(), and call Begin() again once a result other
+    // than kPending has been returned
+    eResult Feed(char c);
+
+private:
+    NMEASentence* m_pSentence;
+    NMEAChecksum m_check;
+};
+
+// System a talker reports on, kSystemUnknown for combined (GN) sentences
+eGNSSystem nmea_talker_system(eTalker eTalkerId);
+// System implied by an NMEA 4.0 extended PRN, for combined sentences
+// from receivers that predate the 4.10 system ID field
+eGNSSystem nmea_prn_system(uint32_t nPRN);
+
+// Field conversions, these do not require NUL termination
+uint32_t nmea_to_uint(std::string_view svField);
+// Hex field such as a 4.10 system or signal ID
+uint32_t nmea_hex_to_uint(std::string_view svField);
+// Decimal field scaled by 10^nDecimals, extra fraction digits are truncated
+int32_t nmea_to_fixed(std::string_view svField, uint32_t nDecimals);
+// (D)DDMM.mmmmmmm coordinate to 1e-7 degrees (unsigned), rounded to nearest,
+// rejected beyond nMaxDegrees, 90 for a latitude and 180 for a longitude
+bool nmea_to_degrees(std::string_view svField, int32_t& nDegrees, uint32_t nMaxDegrees = 180);
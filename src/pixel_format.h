@@ -0,0 +1,119 @@
+/*
+ * Pixel formats for Framebuf
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include "pico/stdlib.h"
+
+typedef enum ePixelFormat
+{
+    MVLSB,  // ssd1306
+    RGB565, // ili9341
+    MHLSB,
+    MHMSB,
+} ePixelFormat;
+
+// PixelFormat
+//
+// Addressing for one pixel format, resolved at compile time so the drawing
+// kernels Framebuf instantiates per format have no switch in their loops.
+// Colours are encoded once per call, then set() writes a pixel and returns
+// whether it changed, for the dirty tracking.
+//
+template <ePixelFormat F>
+struct PixelFormat;
+
+template <>
+struct PixelFormat<MVLSB>
+{
+    static constexpr ePixelFormat eFormat = MVLSB;
+
+    static uint16_t encode(uint16_t color, bool)
+    {
+        return color != 0;
+    }
+    static bool set(void* pBuf, uint16_t nStride, int x, int y, uint16_t color)
+    {
+        uint8_t* b     = &((uint8_t*)pBuf)[(y >> 3) * nStride + x];
+        uint8_t offset = y & 0x07;
+        uint8_t n      = (*b & ~(0x01 << offset)) | (color << offset);
+        if (n == *b)
+        {
+            return false;
+        }
+        *b = n;
+        return true;
+    }
+    static uint16_t get(const void* pBuf, uint16_t nStride, int x, int y)
+    {
+        return (((const uint8_t*)pBuf)[(y >> 3) * nStride + x] >> (y & 0x07)) & 0x01;
+    }
+};
+
+template <>
+struct PixelFormat<RGB565>
+{
+    static constexpr ePixelFormat eFormat = RGB565;
+
+    static uint16_t encode(uint16_t color, bool bRevBytes)
+    {
+        return bRevBytes ? __builtin_bswap16(color) : color;
+    }
+    static bool set(void* pBuf, uint16_t nStride, int x, int y, uint16_t color)
+    {
+        uint16_t* b = &((uint16_t*)pBuf)[x + y * nStride];
+        if (*b == color)
+        {
+            return false;
+        }
+        *b = color;
+        return true;
+    }
+    static uint16_t get(const void* pBuf, uint16_t nStride, int x, int y)
+    {
+        return ((const uint16_t*)pBuf)[x + y * nStride];
+    }
+};
+
+// Horizontal bytes, the leftmost pixel in bit 0 (LSB) or bit 7 (MSB)
+template <ePixelFormat F, bool bMSB>
+struct PixelFormatMH
+{
+    static constexpr ePixelFormat eFormat = F;
+
+    static uint16_t encode(uint16_t color, bool)
+    {
+        return color != 0;
+    }
+    static bool set(void* pBuf, uint16_t nStride, int x, int y, uint16_t color)
+    {
+        uint8_t* b     = &((uint8_t*)pBuf)[(x + y * nStride) >> 3];
+        uint8_t offset = bMSB ? 7 - (x & 0x07) : (x & 0x07);
+        uint8_t n      = (*b & ~(0x01 << offset)) | (color << offset);
+        if (n == *b)
+        {
+            return false;
+        }
+        *b = n;
+        return true;
+    }
+    static uint16_t get(const void* pBuf, uint16_t nStride, int x, int y)
+    {
+        uint8_t offset = bMSB ? 7 - (x & 0x07) : (x & 0x07);
+        return (((const uint8_t*)pBuf)[(x + y * nStride) >> 3] >> offset) & 0x01;
+    }
+};
+
+template <>
+struct PixelFormat<MHLSB> : PixelFormatMH<MHLSB, false>
+{
+};
+
+template <>
+struct PixelFormat<MHMSB> : PixelFormatMH<MHMSB, true>
+{
+};
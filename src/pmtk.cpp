@@ -0,0 +1,263 @@
+/*
+ * MediaTek PMTK configuration
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "pmtk.h"
+
+size_t pmtk_build(char* pOut, size_t nMax, std::string_view svBody)
+{
+    size_t nLen = 1 + svBody.size() + 5; // '$', body, "*HH\r\n"
+    if (nLen + 1 > nMax)
+    {
+        return 0;
+    }
+
+    static constexpr char aHex[] = "0123456789ABCDEF";
+    uint8_t nSum                 = 0;
+    pOut[0]                      = '$';
+    for (size_t i = 0; i < svBody.size(); ++i)
+    {
+        pOut[1 + i] = svBody[i];
+        nSum ^= (uint8_t)svBody[i];
+    }
+    char* p = pOut + 1 + svBody.size();
+    p[0]    = '*';
+    p[1]    = aHex[nSum >> 4];
+    p[2]    = aHex[nSum & 0x0f];
+    p[3]    = '\r';
+    p[4]    = '\n';
+    p[5]    = '\0';
+    return nLen;
+}
+
+size_t pmtk_set_baud(char* pOut, size_t nMax, uint32_t nBaudRate)
+{
+    char szBody[PMTK_MAX_COMMAND];
+    int nLen = snprintf(szBody, sizeof(szBody), "PMTK251,%u", (unsigned)nBaudRate);
+    return pmtk_build(pOut, nMax, std::string_view(szBody, nLen));
+}
+
+size_t pmtk_set_rate(char* pOut, size_t nMax, uint16_t nUpdateMs)
+{
+    char szBody[PMTK_MAX_COMMAND];
+    int nLen = snprintf(szBody, sizeof(szBody), "PMTK220,%u", (unsigned)nUpdateMs);
+    return pmtk_build(pOut, nMax, std::string_view(szBody, nLen));
+}
+
+size_t pmtk_set_output(char* pOut, size_t nMax, uint8_t nSentenceMask, uint8_t nGSVDivider)
+{
+    // 19 fields, each "output once every n fixes" with 0 disabling, of
+    // which only the first six are sentences these modules implement
+    char szBody[PMTK_MAX_COMMAND] = "PMTK314";
+    size_t nLen                   = 7;
+    for (int i = 0; i < 19; ++i)
+    {
+        uint8_t nDivider = 0;
+        if (i < kPMTKNumSentences && (nSentenceMask & pmtk_mask((ePMTKSentence)i)))
+        {
+            nDivider = (i == kPMTKGSV) ? std::clamp<uint8_t>(nGSVDivider, 1, 5) : 1;
+        }
+        szBody[nLen++] = ',';
+        szBody[nLen++] = '0' + nDivider;
+    }
+    return pmtk_build(pOut, nMax, std::string_view(szBody, nLen));
+}
+
+uint32_t pmtk_bytes_per_fix(uint8_t nSentenceMask, uint8_t nGSVDivider)
+{
+    // Typical lengths with a fix, GSV as three sentences for 12 satellites
+    static constexpr uint16_t aBytes[kPMTKNumSentences] = {50, 70, 40, 75, 65, 210};
+
+    uint32_t nBytes = 0;
+    for (int i = 0; i < kPMTKNumSentences; ++i)
+    {
+        if (nSentenceMask & pmtk_mask((ePMTKSentence)i))
+        {
+            nBytes += (i == kPMTKGSV) ? aBytes[i] / std::clamp<uint8_t>(nGSVDivider, 1, 5) : aBytes[i];
+        }
+    }
+    return nBytes;
+}
+
+PMTKConfig::PMTKConfig()
+    : m_pUART(nullptr),
+      m_settings(),
+      m_eState(kIdle),
+      m_nResult(0),
+      m_nBaudRate(0),
+      m_nPrevBaud(0),
+      m_nUpdateMs(0),
+      m_bSent(false),
+      m_nAttempts(0),
+      m_nAwaitCmd(0),
+      m_nAck(kPMTKAckNone),
+      m_bHeard(false),
+      m_nSettle(0),
+      m_nDeadline(0),
+      m_nCommandLen(0),
+      m_szCommand()
+{
+}
+
+void PMTKConfig::Start(uart_inst_t* pUART, const PMTKSettings& settings, uint32_t nCurrentBaud)
+{
+    m_pUART     = pUART;
+    m_settings  = settings;
+    m_nResult   = 0;
+    m_nBaudRate = nCurrentBaud;
+    m_nPrevBaud = nCurrentBaud;
+    if (settings.nBaudRate == nCurrentBaud)
+    {
+        m_nResult |= kBaudOK;
+        next(kOutput);
+    }
+    else
+    {
+        next(kBaud);
+    }
+}
+
+void PMTKConfig::OnSentence(const NMEASentence& oSentence, uint64_t nNow)
+{
+    if (m_eState == kBaud && m_bSent && nNow >= m_nSettle)
+    {
+        // Anything that passes its checksum was sent at the new rate
+        m_bHeard = true;
+    }
+    if (oSentence.eType == kPMTK && oSentence[0] == "$PMTK001" && nmea_to_uint(oSentence[1]) == m_nAwaitCmd)
+    {
+        m_nAck = nmea_to_uint(oSentence[2]);
+    }
+}
+
+void PMTKConfig::Step(uint64_t nNow)
+{
+    switch (m_eState)
+    {
+    case kBaud:
+        if (!m_bSent)
+        {
+            // No ACK for this one, the module just switches once it has
+            // been received, so follow as soon as it is out
+            send();
+            uart_tx_wait_blocking(m_pUART);
+            uart_set_baudrate(m_pUART, m_settings.nBaudRate);
+            m_bSent     = true;
+            m_bHeard    = false;
+            m_nSettle   = nNow + PMTK_BAUD_SETTLE_US;
+            m_nDeadline = nNow + PMTK_BAUD_TIMEOUT_US;
+        }
+        else if (m_bHeard)
+        {
+            m_nBaudRate = m_settings.nBaudRate;
+            m_nResult |= kBaudOK;
+            next(kOutput);
+        }
+        else if (nNow >= m_nDeadline)
+        {
+            // Either the module did not follow or the link does not work at
+            // this rate.  Ask it back in case it did, then go back ourselves.
+            m_nCommandLen = pmtk_set_baud(m_szCommand, sizeof(m_szCommand), m_nPrevBaud);
+            send();
+            uart_tx_wait_blocking(m_pUART);
+            uart_set_baudrate(m_pUART, m_nPrevBaud);
+            next(kOutput);
+        }
+        break;
+    case kOutput:
+        stepAck(nNow, kOutputOK, kRate);
+        break;
+    case kRate:
+        stepAck(nNow, kRateOK, kDone);
+        break;
+    default:
+        break;
+    }
+}
+
+void PMTKConfig::next(eState eNext)
+{
+    m_eState    = eNext;
+    m_bSent     = false;
+    m_nAttempts = 0;
+    m_nAck      = kPMTKAckNone;
+    switch (eNext)
+    {
+    case kBaud:
+        m_nCommandLen = pmtk_set_baud(m_szCommand, sizeof(m_szCommand), m_settings.nBaudRate);
+        break;
+    case kOutput:
+        m_nAwaitCmd   = 314;
+        m_nCommandLen = pmtk_set_output(m_szCommand, sizeof(m_szCommand), m_settings.nSentenceMask, m_settings.nGSVDivider);
+        break;
+    case kRate:
+    {
+        // Lengthen the interval if the output would not fit the link, which
+        // is what happens at 9600 baud if the switch above failed
+        uint32_t nBytesPerSec = m_nBaudRate / 10 * PMTK_LINK_PERCENT / 100;
+        uint32_t nMinMs       = nBytesPerSec ? pmtk_bytes_per_fix(m_settings.nSentenceMask, m_settings.nGSVDivider) * 1000 / nBytesPerSec : 0;
+        nMinMs                = (nMinMs + 99) / 100 * 100;
+        m_nUpdateMs           = std::clamp<uint32_t>(std::max<uint32_t>(m_settings.nUpdateMs, nMinMs), PMTK_MIN_UPDATE_MS, 10000);
+        m_nAwaitCmd           = 220;
+        m_nCommandLen         = pmtk_set_rate(m_szCommand, sizeof(m_szCommand), m_nUpdateMs);
+        break;
+    }
+    case kDone:
+        printf("PMTK configuration: %u baud, %u ms, result %x\n", (unsigned)m_nBaudRate, (unsigned)m_nUpdateMs, m_nResult);
+        break;
+    default:
+        break;
+    }
+}
+
+void PMTKConfig::send()
+{
+    uart_write_blocking(m_pUART, reinterpret_cast<const uint8_t*>(m_szCommand), m_nCommandLen);
+}
+
+void PMTKConfig::stepAck(uint64_t nNow, uint8_t nOK, eState eNext)
+{
+    // Retry on silence or a transient failure, give up on a rejection
+    bool bRetry = (m_nAck == kPMTKAckNone && nNow >= m_nDeadline) || m_nAck == kPMTKAckFailed;
+    if (!m_bSent || (bRetry && m_nAttempts < PMTK_ACK_ATTEMPTS))
+    {
+        m_nAck = kPMTKAckNone;
+        send();
+        ++m_nAttempts;
+        m_bSent     = true;
+        m_nDeadline = nNow + PMTK_ACK_TIMEOUT_US;
+    }
+    else if (m_nAck == kPMTKAckOK)
+    {
+        m_nResult |= nOK;
+        next(eNext);
+    }
+    else if (bRetry || m_nAck != kPMTKAckNone)
+    {
+        // Leave the module as it was
+        next(eNext);
+    }
+}
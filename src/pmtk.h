@@ -0,0 +1,148 @@
+/*
+ * MediaTek PMTK configuration
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+#include <hardware/uart.h>
+
+#include "nmea.h"
+
+auto constexpr PMTK_MAX_COMMAND     = 64;      // longest is PMTK314 with 19 fields
+auto constexpr PMTK_ACK_TIMEOUT_US  = 500000;  // MTK replies within a couple of fixes
+auto constexpr PMTK_ACK_ATTEMPTS    = 3;
+auto constexpr PMTK_BAUD_TIMEOUT_US = 1500000; // time to hear a clean sentence at the new rate
+auto constexpr PMTK_BAUD_SETTLE_US  = 50000;   // lines queued before the switch are still draining
+auto constexpr PMTK_MIN_UPDATE_MS   = 100;     // 10 Hz
+auto constexpr PMTK_LINK_PERCENT    = 80;      // leave headroom on the UART
+
+// Sentences in PMTK314 field order
+typedef enum ePMTKSentence
+{
+    kPMTKGLL,
+    kPMTKRMC,
+    kPMTKVTG,
+    kPMTKGGA,
+    kPMTKGSA,
+    kPMTKGSV,
+    kPMTKNumSentences,
+} ePMTKSentence;
+
+constexpr uint8_t pmtk_mask(ePMTKSentence eSentence)
+{
+    return (uint8_t)(1u << eSentence);
+}
+
+// PMTK001 flag values
+typedef enum ePMTKAck
+{
+    kPMTKAckInvalid     = 0,
+    kPMTKAckUnsupported = 1,
+    kPMTKAckFailed      = 2,
+    kPMTKAckOK          = 3,
+    kPMTKAckNone        = 0xff, // nothing received yet
+} ePMTKAck;
+
+struct PMTKSettings
+{
+    uint32_t nBaudRate;
+    uint16_t nUpdateMs;    // fix interval, 100 to 10000
+    uint8_t nSentenceMask; // pmtk_mask() bits
+    uint8_t nGSVDivider;   // GSV once every n fixes, it is by far the largest
+};
+
+// Wrap a "PMTK..." body as "$PMTK...*HH\r\n", returning the length or 0 if it does not fit
+size_t pmtk_build(char* pOut, size_t nMax, std::string_view svBody);
+// PMTK251 serial rate, the module switches after sending no ACK
+size_t pmtk_set_baud(char* pOut, size_t nMax, uint32_t nBaudRate);
+// PMTK220 position fix interval
+size_t pmtk_set_rate(char* pOut, size_t nMax, uint16_t nUpdateMs);
+// PMTK314 sentence output mask
+size_t pmtk_set_output(char* pOut, size_t nMax, uint8_t nSentenceMask, uint8_t nGSVDivider);
+// Typical bytes per fix for a mask, with GSV averaged over its divider
+uint32_t pmtk_bytes_per_fix(uint8_t nSentenceMask, uint8_t nGSVDivider);
+
+// PMTKConfig
+//
+// Sequences the configuration of a PA6H/PA1616S class module from the GPS
+// thread: baud rate first, as the faster rates and fuller masks need the
+// bandwidth, then the sentence mask, then the fix rate.  Each step is sent,
+// then confirmed by PMTK001 (or for the baud rate, by clean sentences at
+// the new rate) and retried before falling back to what the module already
+// does.  The fix rate is lengthened if the result would not fit the link.
+//
+class PMTKConfig
+{
+public:
+    typedef enum eState
+    {
+        kIdle,
+        kBaud,
+        kOutput,
+        kRate,
+        kDone,
+    } eState;
+
+    // Result() bits
+    auto static constexpr kBaudOK   = 0x01;
+    auto static constexpr kOutputOK = 0x02;
+    auto static constexpr kRateOK   = 0x04;
+
+    PMTKConfig();
+
+    void Start(uart_inst_t* pUART, const PMTKSettings& settings, uint32_t nCurrentBaud);
+    // Call with every valid sentence while Busy()
+    void OnSentence(const NMEASentence& oSentence, uint64_t nNow);
+    // Advance the sequence, call at least every few milliseconds while Busy()
+    void Step(uint64_t nNow);
+
+    bool Busy() const
+    {
+        return m_eState != kIdle && m_eState != kDone;
+    }
+    eState State() const
+    {
+        return m_eState;
+    }
+    uint8_t Result() const
+    {
+        return m_nResult;
+    }
+    uint32_t BaudRate() const
+    {
+        return m_nBaudRate;
+    }
+    uint16_t UpdateMs() const
+    {
+        return m_nUpdateMs;
+    }
+
+private:
+    void next(eState eNext);
+    void send();
+    void stepAck(uint64_t nNow, uint8_t nOK, eState eNext);
+
+    uart_inst_t* m_pUART;
+    PMTKSettings m_settings;
+    eState m_eState;
+    uint8_t m_nResult;
+    uint32_t m_nBaudRate; // what we believe the module is using
+    uint32_t m_nPrevBaud;
+    uint16_t m_nUpdateMs; // what was requested of the module
+    bool m_bSent;         // current step's command is out
+    uint8_t m_nAttempts;
+    uint16_t m_nAwaitCmd; // command number expected in PMTK001
+    uint8_t m_nAck;       // ePMTKAck
+    bool m_bHeard;        // clean sentence since the baud switch settled
+    uint64_t m_nSettle;
+    uint64_t m_nDeadline;
+    size_t m_nCommandLen;
+    char m_szCommand[PMTK_MAX_COMMAND]; // current step's command
+};
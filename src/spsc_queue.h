@@ -0,0 +1,87 @@
+/*
+ * Single producer, single consumer queue
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// SPSCQueue
+//
+// Fixed array of N slots shared between one producer (e.g. an interrupt
+// handler) and one consumer, with no locking or interrupt masking.  The
+// producer fills the slot returned by BeginPush() in place and publishes it
+// with CommitPush(); the consumer reads the slot returned by Front() in place
+// and hands it back with Pop().  Indices are free-running and only ever
+// loaded and stored, as the M0+ has no atomic read-modify-write.
+//
+template <typename T, size_t N>
+class SPSCQueue
+{
+    static_assert(N && (N & (N - 1)) == 0, "SPSCQueue size must be a power of two");
+
+public:
+    SPSCQueue()
+        : m_nHead(0),
+          m_nTail(0),
+          m_nHighWater(0)
+    {
+    }
+    ~SPSCQueue() = default;
+
+    // Producer side
+    T* BeginPush()
+    {
+        uint32_t nTail = m_nTail.load(std::memory_order_relaxed);
+        if (nTail - m_nHead.load(std::memory_order_acquire) == N)
+        {
+            return nullptr; // full
+        }
+        return &m_aSlots[nTail & (N - 1)];
+    }
+    void CommitPush()
+    {
+        uint32_t nTail  = m_nTail.load(std::memory_order_relaxed) + 1;
+        uint32_t nDepth = nTail - m_nHead.load(std::memory_order_relaxed);
+        if (nDepth > m_nHighWater.load(std::memory_order_relaxed))
+        {
+            m_nHighWater.store(nDepth, std::memory_order_relaxed);
+        }
+        m_nTail.store(nTail, std::memory_order_release);
+    }
+
+    // Consumer side
+    const T* Front() const
+    {
+        uint32_t nHead = m_nHead.load(std::memory_order_relaxed);
+        if (nHead == m_nTail.load(std::memory_order_acquire))
+        {
+            return nullptr; // empty
+        }
+        return &m_aSlots[nHead & (N - 1)];
+    }
+    void Pop()
+    {
+        m_nHead.store(m_nHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t size() const
+    {
+        return m_nTail.load(std::memory_order_acquire) - m_nHead.load(std::memory_order_acquire);
+    }
+    size_t HighWater() const
+    {
+        return m_nHighWater.load(std::memory_order_relaxed);
+    }
+
+private:
+    T m_aSlots[N];
+    std::atomic<uint32_t> m_nHead; // written by consumer
+    std::atomic<uint32_t> m_nTail; // written by producer
+    std::atomic<uint32_t> m_nHighWater;
+};
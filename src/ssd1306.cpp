@@ -24,6 +24,10 @@
  * THE SOFTWARE.
  */
 
+#include <string.h>
+#include <algorithm>
+#include <hardware/irq.h>
+
 #include "ssd1306.h"
 
 
@@ -31,8 +35,16 @@ SSD1306::SSD1306(uint nWidth, uint nHeight, bool bExternalVcc)
     : m_dispWidth(nWidth),
       m_dispHeight(nHeight),
       m_bExternalVcc(bExternalVcc),
-      m_nPages(nHeight / 8)
+      m_nPages(nHeight / 8),
+      m_stats(),
+      m_pShadow(new uint8_t[nWidth * (nHeight / 8)]),
+      m_bShadowValid(false)
+{
+}
+
+SSD1306::~SSD1306()
 {
+    delete[] m_pShadow;
 }
 
 void SSD1306::Reset()
@@ -41,60 +53,64 @@ void SSD1306::Reset()
 
 void SSD1306::Initialize()
 {
-    Framebuf::Initialize(m_dispWidth, m_dispHeight, MVLSB);
+    Framebuf::Initialize(m_dispWidth, m_dispHeight, MVLSB, false, 0, 1); // room for the I2C control byte
 
     initInternal();
 
-    write_cmd(OLED_SET_DISP); // display off
+    // The whole sequence goes as one command list
+    const uint8_t aInit[] = {
+        OLED_SET_DISP, // display off
 
-    /* memory mapping */
-    write_cmd(OLED_SET_MEM_ADDR); // set memory address mode
-    write_cmd(0x00);              // horizontal addressing mode
+        /* memory mapping */
+        OLED_SET_MEM_ADDR, // set memory address mode
+        0x00,              // horizontal addressing mode
 
-    /* resolution and layout */
-    write_cmd(OLED_SET_DISP_START_LINE); // set display start line to 0
+        /* resolution and layout */
+        OLED_SET_DISP_START_LINE, // set display start line to 0
 
-    write_cmd(OLED_SET_SEG_REMAP | 0x01); // set segment re-map
-    // column address 127 is mapped to SEG0
+        OLED_SET_SEG_REMAP | 0x01, // set segment re-map
+        // column address 127 is mapped to SEG0
 
-    write_cmd(OLED_SET_MUX_RATIO); // set multiplex ratio
-    write_cmd(m_dispHeight - 1);   // display height
+        OLED_SET_MUX_RATIO,          // set multiplex ratio
+        (uint8_t)(m_dispHeight - 1), // display height
 
-    write_cmd(OLED_SET_COM_OUT_DIR | 0x08); // set COM (common) output scan direction
-    // scan from bottom up, COM[N-1] to COM0
+        OLED_SET_COM_OUT_DIR | 0x08, // set COM (common) output scan direction
+        // scan from bottom up, COM[N-1] to COM0
 
-    write_cmd(OLED_SET_DISP_OFFSET); // set display offset
-    write_cmd(0x00);                 // no offset
+        OLED_SET_DISP_OFFSET, // set display offset
+        0x00,                 // no offset
 
-    write_cmd(OLED_SET_COM_PIN_CFG);                           // set COM (common) pins hardware configuration
-    write_cmd((m_dispWidth > 2 * m_dispHeight) ? 0x02 : 0x12); // manufacturer magic number
-                                                               // 0x02 if self.width > 2 * self.height else 0x12,
+        OLED_SET_COM_PIN_CFG,                                      // set COM (common) pins hardware configuration
+        (uint8_t)((m_dispWidth > 2 * m_dispHeight) ? 0x02 : 0x12), // manufacturer magic number
+                                                                   // 0x02 if self.width > 2 * self.height else 0x12,
 
-    /* timing and driving scheme */
-    write_cmd(OLED_SET_DISP_CLK_DIV); // set display clock divide ratio
-    write_cmd(0x80);                  // div ratio of 1, standard freq
+        /* timing and driving scheme */
+        OLED_SET_DISP_CLK_DIV, // set display clock divide ratio
+        0x80,                  // div ratio of 1, standard freq
 
-    write_cmd(OLED_SET_PRECHARGE);           // set pre-charge period
-    write_cmd(m_bExternalVcc ? 0x22 : 0xF1); // Vcc
+        OLED_SET_PRECHARGE,                      // set pre-charge period
+        (uint8_t)(m_bExternalVcc ? 0x22 : 0xF1), // Vcc
 
-    write_cmd(OLED_SET_VCOM_DESEL); // set VCOMH deselect level
-    write_cmd(0x30);                // 0.83xVcc
+        OLED_SET_VCOM_DESEL, // set VCOMH deselect level
+        0x30,                // 0.83xVcc
 
-    /* display */
-    write_cmd(OLED_SET_CONTRAST); // set contrast control
-    write_cmd(0xFF);
+        /* display */
+        OLED_SET_CONTRAST, // set contrast control
+        0xFF,
 
-    write_cmd(OLED_SET_ENTIRE_ON); // set entire display on to follow RAM content
+        OLED_SET_ENTIRE_ON, // set entire display on to follow RAM content
 
-    write_cmd(OLED_SET_NORM_INV); // set normal (not inverted) display
+        OLED_SET_NORM_INV, // set normal (not inverted) display
 
-    write_cmd(OLED_SET_CHARGE_PUMP);         // set charge pump
-    write_cmd(m_bExternalVcc ? 0x10 : 0x14); // Vcc
+        OLED_SET_CHARGE_PUMP,                    // set charge pump
+        (uint8_t)(m_bExternalVcc ? 0x10 : 0x14), // Vcc
 
-    write_cmd(OLED_SET_SCROLL | 0x00); // deactivate horizontal scrolling if set
-    // this is necessary as memory writes will corrupt if scrolling was enabled
+        OLED_SET_SCROLL | 0x00, // deactivate horizontal scrolling if set
+        // this is necessary as memory writes will corrupt if scrolling was enabled
 
-    write_cmd(OLED_SET_DISP | 0x01); // turn display on
+        OLED_SET_DISP | 0x01, // turn display on
+    };
+    write_cmds(aInit, sizeof(aInit));
 }
 
 void SSD1306::DisplayOff()
@@ -109,40 +125,140 @@ void SSD1306::DisplayOn()
 
 void SSD1306::SetContrast(uint8_t contrast)
 {
-    write_cmd(OLED_SET_CONTRAST); // set contrast control
-    write_cmd(contrast);
+    const uint8_t aCmds[] = {OLED_SET_CONTRAST, contrast}; // set contrast control
+    write_cmds(aCmds, sizeof(aCmds));
 }
 
 void SSD1306::Invert(bool bInvert)
 {
-    write_cmd(OLED_SET_NORM_INV | bInvert ? 0x01 : 0x00);
+    write_cmd(OLED_SET_NORM_INV | (bInvert ? 0x01 : 0x00));
 }
 
 void SSD1306::Rotate(bool bRotate)
 {
-    write_cmd(OLED_SET_COM_OUT_DIR | (bRotate ? 0x08 : 0x00)); // set COM (common) output scan direction
-    write_cmd(OLED_SET_SEG_REMAP | (bRotate ? 0x01 : 0x00));   // set segment re-map
+    const uint8_t aCmds[] = {
+        (uint8_t)(OLED_SET_COM_OUT_DIR | (bRotate ? 0x08 : 0x00)), // set COM (common) output scan direction
+        (uint8_t)(OLED_SET_SEG_REMAP | (bRotate ? 0x01 : 0x00)),   // set segment re-map
+    };
+    write_cmds(aCmds, sizeof(aCmds));
 }
 
 void SSD1306::Show()
 {
-    uint8_t x0 = 0;
-    uint8_t x1 = m_dispWidth - 1;
-    if (m_dispWidth != 128)
+    uint8_t* pBuf               = reinterpret_cast<uint8_t*>(buffer());
+    uint32_t nStart             = m_stats.nDataBytes;
+    uint32_t nStartTransactions = m_stats.nTransactions;
+    beginShow();
+
+    bool bSent = true;
+    uint16_t x0, x1;
+    for (uint nPage = 0; nPage < m_nPages; ++nPage)
+    {
+        if (!dirty(nPage, x0, x1))
+        {
+            continue;
+        }
+        const uint8_t* pNew = pBuf + nPage * m_dispWidth;
+        uint8_t* pOld       = m_pShadow + nPage * m_dispWidth;
+
+        if (!m_bShadowValid)
+        {
+            // Nothing to diff against, runs of fully dirty pages are
+            // contiguous in the buffer and go as one window
+            uint nLast = nPage;
+            uint16_t x0Next, x1Next;
+            while (x0 == 0 && x1 == m_dispWidth - 1 && nLast + 1 < m_nPages && dirty(nLast + 1, x0Next, x1Next) && x0Next == x0 && x1Next == x1)
+            {
+                ++nLast;
+            }
+            bSent = sendWindow(nPage, nLast, x0, x1) && bSent;
+            memcpy(pOld, pNew, (nLast - nPage + 1) * m_dispWidth);
+            nPage = nLast;
+            continue;
+        }
+
+        // Diff the dirty span against the shadow a word at a time, sending
+        // each run of changed columns in a window of its own unless the gap
+        // to the next run is cheaper to send than a new window
+        int nRunStart = -1;
+        int nRunEnd   = -1;
+        for (uint x = x0 & ~3u; x <= x1;)
+        {
+            uint32_t nNew, nOld;
+            if (x + 4 <= m_dispWidth)
+            {
+                memcpy(&nNew, pNew + x, 4);
+                memcpy(&nOld, pOld + x, 4);
+                if (nNew == nOld)
+                {
+                    x += 4;
+                    continue;
+                }
+            }
+            for (uint xEnd = std::min<uint>(x + 4, m_dispWidth); x < xEnd; ++x)
+            {
+                if (pNew[x] == pOld[x])
+                {
+                    continue;
+                }
+                if (nRunStart >= 0 && (int)x - nRunEnd - 1 > OLED_WINDOW_COST)
+                {
+                    bSent     = sendWindow(nPage, nPage, nRunStart, nRunEnd) && bSent;
+                    nRunStart = -1;
+                }
+                if (nRunStart < 0)
+                {
+                    nRunStart = x;
+                }
+                nRunEnd = x;
+            }
+        }
+        if (nRunStart >= 0)
+        {
+            bSent = sendWindow(nPage, nPage, nRunStart, nRunEnd) && bSent;
+        }
+        memcpy(pOld + x0, pNew + x0, x1 - x0 + 1);
+    }
+    clear_dirty();
+    m_bShadowValid = true;
+    endShow();
+    if (!bSent)
     {
-        // narrow displays use centred columns
-        uint col_offset = (128 - m_dispWidth) / 2;
-        x0 += col_offset;
-        x1 += col_offset;
+        invalidateShadow();
     }
-    write_cmd(OLED_SET_COL_ADDR);
-    write_cmd(x0);
-    write_cmd(x1);
-    write_cmd(OLED_SET_PAGE_ADDR);
-    write_cmd(0);
-    write_cmd(m_nPages - 1);
-    uint buflen = (x1 - x0 + 1) * m_nPages;
-    write_data(reinterpret_cast<uint8_t*>(buffer()), buflen);
+
+    ++m_stats.nFrames;
+    m_stats.nLastBytes        = m_stats.nDataBytes - nStart;
+    m_stats.nLastTransactions = m_stats.nTransactions - nStartTransactions;
+}
+
+void SSD1306::invalidateShadow()
+{
+    m_bShadowValid = false;
+    mark_dirty(0, 0, m_dispWidth, m_dispHeight);
+}
+
+bool SSD1306::sendWindow(uint nPage0, uint nPage1, uint x0, uint x1)
+{
+    // narrow displays use centred columns
+    uint col_offset       = (128 - m_dispWidth) / 2;
+    const uint8_t aCmds[] = {
+        OLED_SET_COL_ADDR,
+        (uint8_t)(x0 + col_offset),
+        (uint8_t)(x1 + col_offset),
+        OLED_SET_PAGE_ADDR,
+        (uint8_t)nPage0,
+        (uint8_t)nPage1,
+    };
+    // Data without its window would land wherever the last one left off
+    uint nLen = (x1 - x0 + 1) * (nPage1 - nPage0 + 1);
+    if (!write_cmds(aCmds, sizeof(aCmds)) || !write_data(reinterpret_cast<uint8_t*>(buffer()) + nPage0 * m_dispWidth + x0, nLen))
+    {
+        return false;
+    }
+    m_stats.nDataBytes += nLen;
+    ++m_stats.nWindows;
+    return true;
 }
 
 void SSD1306::SetPixel(int x, int y, uint16_t color)
@@ -209,47 +325,360 @@ void SSD1306::Text(const char* str, int x, int y, uint16_t color, const BitmapFo
 // SSD1306_I2C
 //
 
+SSD1306_I2C* SSD1306_I2C::sm_apAsync[NUM_DMA_CHANNELS] = {};
+
 SSD1306_I2C::SSD1306_I2C(uint nWidth, uint nHeight, i2c_inst_t* i2c, uint8_t addr, bool bExternalVcc)
     : SSD1306(nWidth, nHeight, bExternalVcc),
       m_i2c(i2c),
-      m_addr(addr)
+      m_addr(addr),
+      m_nDMA(-1),
+      m_bQueueing(false),
+      m_pStream(nullptr),
+      m_nStreamLen(0),
+      m_nStreamMax(0),
+      m_pFlushCB(nullptr),
+      m_pFlushCtx(nullptr)
 {
 }
 
+SSD1306_I2C::~SSD1306_I2C()
+{
+    SetAsync(false);
+}
+
 void SSD1306_I2C::initInternal()
 {
 }
 
-void SSD1306_I2C::write_cmd(uint8_t cmd)
+bool SSD1306_I2C::write_cmds(const uint8_t* pCmds, uint nLen)
 {
     // I2C write process expects a control byte followed by data
     // this "data" can be a command or data to follow up a command
 
-    // Co = 1, D/C = 0 => the driver expects a command
-    uint8_t buf[2] = {0x80, cmd};
-    i2c_write_blocking(m_i2c, (OLED_ADDR & OLED_WRITE_MODE), buf, 2, false);
+    // Co = 0, D/C = 0 => every byte to the STOP is a command or argument,
+    // so a whole list costs one START, address and control byte
+    if (m_bQueueing)
+    {
+        queue(0x00, pCmds, nLen); // a refused transaction shows up later as a TX abort, see Busy()
+        return true;
+    }
+    Wait();
+    while (nLen > 0)
+    {
+        uint nChunk = std::min<uint>(nLen, OLED_MAX_CMD_LIST);
+        uint8_t buf[1 + OLED_MAX_CMD_LIST];
+        buf[0] = 0x00;
+        memcpy(buf + 1, pCmds, nChunk);
+        int nWritten = i2c_write_blocking(m_i2c, (OLED_ADDR & OLED_WRITE_MODE), buf, nChunk + 1, false);
+        countTransaction();
+        if (nWritten != (int)nChunk + 1)
+        {
+            return false; // not acknowledged, the rest of the list would be out of context
+        }
+        pCmds += nChunk;
+        nLen -= nChunk;
+    }
+    return true;
 }
 
-void SSD1306_I2C::write_data(uint8_t* buf, uint nLen)
+bool SSD1306_I2C::write_data(uint8_t* buf, uint nLen)
 {
     // in horizontal addressing mode, the column address pointer auto-increments
-    // and then wraps around to the next page, so we can send the entire frame
-    // buffer in one gooooooo!
+    // and then wraps around to the next page, so a whole window goes in one write
+
+    // Co = 0, D/C = 1 => the driver expects data to be written to RAM
+    if (m_bQueueing)
+    {
+        queue(0x40, buf, nLen);
+        return true;
+    }
+    Wait();
+
+    // buf always points into the framebuffer, which keeps a byte of headroom,
+    // so the control byte is put in front of the data in place rather than
+    // copying the data after it, and whatever was there is put back
+    uint8_t save = buf[-1];
+    buf[-1]      = 0x40;
+    int nWritten = i2c_write_blocking(m_i2c, (OLED_ADDR & OLED_WRITE_MODE), buf - 1, nLen + 1, false);
+    buf[-1]      = save;
+    countTransaction();
+    return nWritten == (int)nLen + 1;
+}
 
-    // copy our frame buffer into a new buffer because we need to add the control byte
-    // to the beginning
+bool SSD1306_I2C::SetAsync(bool bAsync, flushCallback pCB, void* pCtx)
+{
+    if (m_nDMA >= 0)
+    {
+        Wait();
+        dma_channel_set_irq0_enabled(m_nDMA, false);
+        sm_apAsync[m_nDMA] = nullptr;
+        dma_channel_unclaim(m_nDMA);
+        m_nDMA = -1;
+        delete[] m_pStream;
+        m_pStream = nullptr;
+    }
+    if (!bAsync)
+    {
+        return true;
+    }
 
-    // TODO find a more memory-efficient way to do this..
-    // maybe break the data transfer into pages?
-    uint8_t* temp_buf = new uint8_t[nLen + 1]; // reinterpret_cast<uint8_t*>(malloc(nLen + 1));
+    m_nDMA = dma_claim_unused_channel(false);
+    if (m_nDMA < 0)
+    {
+        return false;
+    }
+    // A whole frame, plus a window's command list and both control bytes for
+    // every run Show() might split a page into
+    uint nPages  = Height() / OLED_PAGE_HEIGHT;
+    m_nStreamMax = Width() * nPages + nPages * (Width() / (OLED_WINDOW_COST + 1) + 1) * 8;
+    m_pStream    = new uint16_t[m_nStreamMax];
+    m_nStreamLen = 0;
+    m_pFlushCB   = pCB;
+    m_pFlushCtx  = pCtx;
+
+    sm_apAsync[m_nDMA] = this;
+    if (nullptr != pCB)
+    {
+        static bool bHandler = false;
+        if (!bHandler)
+        {
+            irq_add_shared_handler(DMA_IRQ_0, dmaIRQ, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+            irq_set_enabled(DMA_IRQ_0, true);
+            bHandler = true;
+        }
+        dma_channel_set_irq0_enabled(m_nDMA, true);
+    }
+    return true;
+}
 
-    for (uint i = 1; i < nLen + 1; i++)
+bool SSD1306_I2C::Busy()
+{
+    if (m_nDMA < 0)
     {
-        temp_buf[i] = buf[i - 1];
+        return false;
     }
-    // Co = 0, D/C = 1 => the driver expects data to be written to RAM
-    temp_buf[0] = 0x40;
-    i2c_write_blocking(m_i2c, (OLED_ADDR & OLED_WRITE_MODE), temp_buf, nLen + 1, false);
+    i2c_hw_t* pHW = i2c_get_hw(m_i2c);
+    if (0 != pHW->tx_abrt_source)
+    {
+        // A transaction was not acknowledged and the controller is flushing
+        // the rest of the frame.  Stop the DMA before clearing the abort, or
+        // what is left would go out without its control byte, and have the
+        // next Show() send the whole frame again.
+        dma_channel_abort(m_nDMA);
+        (void)pHW->clr_tx_abrt;
+        invalidateShadow();
+    }
+    // The last bytes are still in the controller's FIFO once the DMA is done
+    uint32_t nStatus = pHW->status;
+    return dma_channel_is_busy(m_nDMA) || !(nStatus & I2C_IC_STATUS_TFE_BITS) || (nStatus & I2C_IC_STATUS_ACTIVITY_BITS);
+}
+
+void SSD1306_I2C::beginShow()
+{
+    if (m_nDMA >= 0)
+    {
+        Wait(); // the stream is still being read
+        m_nStreamLen = 0;
+        m_bQueueing  = true;
+    }
+}
+
+void SSD1306_I2C::endShow()
+{
+    m_bQueueing = false;
+    if (0 != m_nStreamLen)
+    {
+        startDMA();
+    }
+}
 
-    delete[] temp_buf; // free(temp_buf);
+void SSD1306_I2C::queue(uint8_t nControl, const uint8_t* pData, uint nLen)
+{
+    if (m_nStreamLen + nLen + 1 > m_nStreamMax)
+    {
+        // Cannot happen for frames Show() builds, but send what there is rather than lose it
+        startDMA();
+        Wait();
+        m_nStreamLen = 0;
+    }
+    // One IC_DATA_CMD word per byte, with STOP on the last of each transaction
+    m_pStream[m_nStreamLen++] = nControl;
+    for (uint i = 0; i < nLen; ++i)
+    {
+        m_pStream[m_nStreamLen++] = pData[i];
+    }
+    m_pStream[m_nStreamLen - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    countTransaction();
+}
+
+void SSD1306_I2C::startDMA()
+{
+    // The controller was idle when the frame was started, so the target can be set
+    i2c_hw_t* pHW = i2c_get_hw(m_i2c);
+    pHW->enable   = 0;
+    pHW->tar      = (OLED_ADDR & OLED_WRITE_MODE);
+    pHW->enable   = 1;
+
+    // 16-bit writes, the upper byte carries the STOP bit
+    dma_channel_config c = dma_channel_get_default_config(m_nDMA);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(m_i2c, true));
+    dma_channel_configure(m_nDMA, &c, &pHW->data_cmd, m_pStream, m_nStreamLen, true);
+}
+
+void SSD1306_I2C::dmaIRQ()
+{
+    for (uint i = 0; i < NUM_DMA_CHANNELS; ++i)
+    {
+        SSD1306_I2C* pThis = sm_apAsync[i];
+        if (nullptr != pThis && dma_channel_get_irq0_status(i))
+        {
+            dma_channel_acknowledge_irq0(i);
+            if (nullptr != pThis->m_pFlushCB)
+            {
+                (*pThis->m_pFlushCB)(pThis->m_pFlushCtx);
+            }
+        }
+    }
+}
+
+//
+// SSD1306_SPI
+//
+
+SSD1306_SPI::SSD1306_SPI(uint nWidth, uint nHeight, spi_inst_t* spi, uint nDCPin, uint nCSPin, uint nResetPin, bool bExternalVcc)
+    : SSD1306(nWidth, nHeight, bExternalVcc),
+      m_spi(spi),
+      m_nDCPin(nDCPin),
+      m_nCSPin(nCSPin),
+      m_nResetPin(nResetPin),
+      m_nDMA(-1),
+      m_bBatching(false),
+      m_aCmd(),
+      m_nCmdLen(0)
+{
+}
+
+SSD1306_SPI::~SSD1306_SPI()
+{
+    if (m_nDMA >= 0)
+    {
+        finish();
+        dma_channel_unclaim(m_nDMA);
+    }
+}
+
+void SSD1306_SPI::initInternal()
+{
+    gpio_init(m_nDCPin);
+    gpio_set_dir(m_nDCPin, GPIO_OUT);
+    gpio_put(m_nDCPin, 0);
+    gpio_init(m_nCSPin);
+    gpio_set_dir(m_nCSPin, GPIO_OUT);
+    gpio_put(m_nCSPin, 1);
+
+    // Hardware reset, the controller needs at least 3 us low
+    gpio_init(m_nResetPin);
+    gpio_set_dir(m_nResetPin, GPIO_OUT);
+    gpio_put(m_nResetPin, 1);
+    sleep_ms(1);
+    gpio_put(m_nResetPin, 0);
+    sleep_ms(10);
+    gpio_put(m_nResetPin, 1);
+
+    if (m_nDMA < 0)
+    {
+        m_nDMA = dma_claim_unused_channel(false);
+    }
+}
+
+// SPI has no acknowledge, so writes cannot fail
+bool SSD1306_SPI::write_cmds(const uint8_t* pCmds, uint nLen)
+{
+    while (nLen > 0)
+    {
+        if (m_nCmdLen == sizeof(m_aCmd))
+        {
+            flushCommands();
+        }
+        uint nChunk = std::min<uint>(nLen, sizeof(m_aCmd) - m_nCmdLen);
+        memcpy(m_aCmd + m_nCmdLen, pCmds, nChunk);
+        m_nCmdLen += nChunk;
+        pCmds += nChunk;
+        nLen -= nChunk;
+    }
+    if (!m_bBatching)
+    {
+        flushCommands();
+    }
+    return true;
+}
+
+bool SSD1306_SPI::write_data(uint8_t* buf, uint nLen)
+{
+    flushCommands();
+    finish();
+
+    // D/C = 1 => the driver expects data to be written to RAM
+    gpio_put(m_nDCPin, 1);
+    gpio_put(m_nCSPin, 0);
+    if (m_nDMA < 0)
+    {
+        spi_write_blocking(m_spi, buf, nLen);
+        gpio_put(m_nCSPin, 1);
+        countTransaction();
+        return true;
+    }
+    // Left running, the next write or the end of Show() waits for it
+    dma_channel_config c = dma_channel_get_default_config(m_nDMA);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(m_spi, true));
+    dma_channel_configure(m_nDMA, &c, &spi_get_hw(m_spi)->dr, buf, nLen, true);
+    countTransaction();
+    return true;
+}
+
+bool SSD1306_SPI::Busy()
+{
+    // The last bytes are still shifting out once the DMA is done
+    return (m_nDMA >= 0 && dma_channel_is_busy(m_nDMA)) || spi_is_busy(m_spi);
+}
+
+void SSD1306_SPI::beginShow()
+{
+    m_bBatching = true;
+}
+
+void SSD1306_SPI::endShow()
+{
+    m_bBatching = false;
+    flushCommands();
+    finish();
+}
+
+void SSD1306_SPI::flushCommands()
+{
+    if (0 == m_nCmdLen)
+    {
+        return;
+    }
+    finish();
+
+    // D/C = 0 => the driver expects commands
+    gpio_put(m_nDCPin, 0);
+    gpio_put(m_nCSPin, 0);
+    spi_write_blocking(m_spi, m_aCmd, m_nCmdLen);
+    gpio_put(m_nCSPin, 1);
+    m_nCmdLen = 0;
+    countTransaction();
+}
+
+void SSD1306_SPI::finish()
+{
+    Wait();
+    gpio_put(m_nCSPin, 1);
 }
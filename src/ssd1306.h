@@ -10,6 +10,9 @@
 #pragma once
 
 #include <hardware/i2c.h>
+#include <hardware/spi.h>
+#include <hardware/gpio.h>
+#include <hardware/dma.h>
 #include "framebuf.h"
 #include "font.h"
 
@@ -44,6 +47,12 @@
 #define OLED_NUM_PAGES           (OLED_HEIGHT / OLED_PAGE_HEIGHT)
 #define OLED_BUF_LEN             (OLED_NUM_PAGES * OLED_WIDTH)
 
+// Bytes on the wire to set a column/page window and start a data write,
+// unchanged runs shorter than this are sent rather than skipped
+#define OLED_WINDOW_COST         10
+
+#define OLED_MAX_CMD_LIST        32 // commands sent in one transaction, longer lists are split
+
 #define OLED_WRITE_MODE          0xFE
 #define OLED_READ_MODE           0xFF
 
@@ -53,13 +62,24 @@ constexpr auto COLOUR_BLACK = 0;
 constexpr auto COLOUR_BLUE = 1;
 constexpr auto COLOUR_RED = 1;
 
+// Show() traffic, data bytes are framebuffer bytes written to display RAM
+struct SSD1306Stats
+{
+    uint32_t nFrames;
+    uint32_t nDataBytes;
+    uint32_t nWindows;          // column/page address windows set
+    uint32_t nTransactions;     // bus transactions, including commands outside Show()
+    uint16_t nLastBytes;        // data bytes sent by the most recent Show()
+    uint16_t nLastTransactions; // bus transactions started by the most recent Show()
+};
+
 class SSD1306 : public Framebuf
 {
 public:
     typedef std::shared_ptr<SSD1306> Shared;
 
     SSD1306(uint nWidth, uint nHeight, bool bExternalVcc);
-    virtual ~SSD1306() = default;
+    virtual ~SSD1306();
 
     void Reset();
     void Initialize();
@@ -68,7 +88,24 @@ public:
     void SetContrast(uint8_t contrast);
     void Invert(bool bInvert);
     void Rotate(bool bRotate);
+    // Send the bytes of the framebuffer that differ from what was last sent
     void Show();
+    // A frame queued by Show() is still being sent
+    virtual bool Busy()
+    {
+        return false;
+    }
+    void Wait()
+    {
+        while (Busy())
+        {
+            tight_loop_contents();
+        }
+    }
+    const SSD1306Stats& GetStats() const
+    {
+        return m_stats;
+    }
 
     // Framebuff shim methods
     void SetPixel(int x, int y, uint16_t color);
@@ -93,28 +130,120 @@ public:
         return m_dispHeight;
     }
 
+protected:
+    // Drivers count each bus transaction they start
+    void countTransaction()
+    {
+        ++m_stats.nTransactions;
+    }
+    // The display may not hold what was last sent, so the next Show() sends
+    // the whole frame
+    void invalidateShadow();
+
 private:
-    virtual void initInternal()                      = 0;
-    virtual void write_cmd(uint8_t cmd)              = 0;
-    virtual void write_data(uint8_t* buf, uint nLen) = 0;
+    bool sendWindow(uint nPage0, uint nPage1, uint x0, uint x1);
+    bool write_cmd(uint8_t cmd)
+    {
+        return write_cmds(&cmd, 1);
+    }
+
+    // Show() brackets its writes with these, so a driver can queue the
+    // frame and start sending it once it is complete
+    virtual void beginShow()
+    {
+    }
+    virtual void endShow()
+    {
+    }
+    virtual void initInternal()                              = 0;
+    // Commands and their arguments, sent as one transaction where the bus
+    // allows.  Both writes return false if the bus reported a failure.
+    virtual bool write_cmds(const uint8_t* pCmds, uint nLen) = 0;
+    // buf is within the framebuffer, buf[-1] may be used during the call
+    virtual bool write_data(uint8_t* buf, uint nLen)         = 0;
 
     uint16_t m_dispWidth;
     uint16_t m_dispHeight;
     bool m_bExternalVcc;
     uint m_nPages;
+    SSD1306Stats m_stats;
+    uint8_t* m_pShadow;  // display RAM as last sent
+    bool m_bShadowValid; // false until the whole frame has been sent without error
 };
 
 class SSD1306_I2C : public SSD1306
 {
 public:
+    typedef void (*flushCallback)(void* pCtx);
+
     SSD1306_I2C(uint nWidth, uint nHeight, i2c_inst_t* i2c, uint8_t addr = 0x3C, bool bExternalVcc = false);
-    virtual ~SSD1306_I2C() = default;
+    virtual ~SSD1306_I2C();
+
+    // Have Show() queue the frame to a DMA channel feeding the I2C controller
+    // and return at once, so the next frame can be drawn while this one is on
+    // the wire.  pCB is called from the DMA interrupt as each frame has been
+    // handed to the controller.  Returns false, staying synchronous, if no
+    // channel is free.
+    bool SetAsync(bool bAsync, flushCallback pCB = nullptr, void* pCtx = nullptr);
+    bool Busy() override;
 
 private:
     void initInternal() override;
-    void write_cmd(uint8_t cmd) override;
-    void write_data(uint8_t* buf, uint nLen) override;
+    bool write_cmds(const uint8_t* pCmds, uint nLen) override;
+    bool write_data(uint8_t* buf, uint nLen) override;
+    void beginShow() override;
+    void endShow() override;
+
+    void queue(uint8_t nControl, const uint8_t* pData, uint nLen);
+    void startDMA();
+    static void dmaIRQ();
+
+    static SSD1306_I2C* sm_apAsync[NUM_DMA_CHANNELS]; // by DMA channel, for dmaIRQ()
 
     i2c_inst_t* m_i2c;
     uint8_t m_addr;
+    int m_nDMA;          // -1 while synchronous
+    bool m_bQueueing;    // inside Show()
+    uint16_t* m_pStream; // IC_DATA_CMD words, a copy of the frame so drawing can go on
+    uint m_nStreamLen;
+    uint m_nStreamMax;
+    flushCallback m_pFlushCB;
+    void* m_pFlushCtx;
+};
+
+// SSD1306_SPI
+//
+// 4-wire SPI, with commands and data on the same line told apart by D/C#.
+// Commands are collected and sent in one burst ahead of the data they set
+// up, and each data write goes by DMA while Show() works out the next
+// window.  Show() returns once the last byte is out, as the data is read
+// straight from the framebuffer; at 10 MHz a full frame takes under a
+// millisecond.  The SPI port and its SCK/TX pins are set up by the caller.
+//
+class SSD1306_SPI : public SSD1306
+{
+public:
+    SSD1306_SPI(uint nWidth, uint nHeight, spi_inst_t* spi, uint nDCPin, uint nCSPin, uint nResetPin, bool bExternalVcc = false);
+    virtual ~SSD1306_SPI();
+
+    bool Busy() override;
+
+private:
+    void initInternal() override;
+    bool write_cmds(const uint8_t* pCmds, uint nLen) override;
+    bool write_data(uint8_t* buf, uint nLen) override;
+    void beginShow() override;
+    void endShow() override;
+
+    void flushCommands();
+    void finish();
+
+    spi_inst_t* m_spi;
+    uint m_nDCPin;
+    uint m_nCSPin;
+    uint m_nResetPin;
+    int m_nDMA;       // -1 if none was free, data then goes by spi_write_blocking()
+    bool m_bBatching; // inside Show(), commands wait for the data they set up
+    uint8_t m_aCmd[OLED_MAX_CMD_LIST];
+    uint m_nCmdLen;
 };
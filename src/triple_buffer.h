@@ -0,0 +1,81 @@
+/*
+ * Triple buffer for handing snapshots between cores
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <pico/sync.h>
+
+// TripleBuffer
+//
+// The producer always has a back buffer to write into and the consumer
+// always has a stable front buffer to read, so neither side ever waits on
+// the other.  Publish() swaps the back buffer with the middle one; Acquire()
+// swaps the middle buffer to the front if it holds something newer.  Only
+// the index swaps are guarded, by a hardware spin lock, which makes this
+// safe across cores.
+//
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer()
+        : m_nBack(0),
+          m_nMiddle(1),
+          m_nFront(2),
+          m_bFresh(false)
+    {
+        critical_section_init(&m_cs);
+    }
+    ~TripleBuffer()
+    {
+        critical_section_deinit(&m_cs);
+    }
+
+    // Producer side
+    T& Back()
+    {
+        return m_aBuf[m_nBack];
+    }
+    void Publish()
+    {
+        critical_section_enter_blocking(&m_cs);
+        uint8_t nTemp = m_nMiddle;
+        m_nMiddle     = m_nBack;
+        m_nBack       = nTemp;
+        m_bFresh      = true;
+        critical_section_exit(&m_cs);
+    }
+
+    // Consumer side, returns false if nothing newer has been published
+    bool Acquire()
+    {
+        bool bFresh = false;
+        critical_section_enter_blocking(&m_cs);
+        if (m_bFresh)
+        {
+            uint8_t nTemp = m_nMiddle;
+            m_nMiddle     = m_nFront;
+            m_nFront      = nTemp;
+            m_bFresh      = false;
+            bFresh        = true;
+        }
+        critical_section_exit(&m_cs);
+        return bFresh;
+    }
+    const T& Front() const
+    {
+        return m_aBuf[m_nFront];
+    }
+
+private:
+    T m_aBuf[3];
+    uint8_t m_nBack;
+    uint8_t m_nMiddle;
+    uint8_t m_nFront;
+    bool m_bFresh;
+    critical_section_t m_cs;
+};
@@ -0,0 +1,332 @@
+/*
+ * u-blox UBX protocol helpers
+ *
+ * Copyright (c) 2025 Erik Tkal
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ubx.h"
+
+void UBXParser::Begin(UBXFrame* pFrame)
+{
+    m_pFrame              = pFrame;
+    m_pFrame->nClass      = 0;
+    m_pFrame->nId         = 0;
+    m_pFrame->nPayloadLen = 0;
+    m_pFrame->nLen        = 0;
+    m_eState              = kSync1;
+    m_nCkA                = 0;
+    m_nCkB                = 0;
+}
+
+UBXParser::eResult UBXParser::Feed(uint8_t c)
+{
+    UBXFrame& oFrame = *m_pFrame;
+    if (oFrame.nLen < UBX_MAX_FRAME)
+    {
+        oFrame.aData[oFrame.nLen] = c;
+    }
+    ++oFrame.nLen;
+
+    // Checksum covers everything between the sync bytes and the checksum
+    if (m_eState >= kClass && m_eState <= kPayload)
+    {
+        m_nCkA += c;
+        m_nCkB += m_nCkA;
+    }
+
+    switch (m_eState)
+    {
+    case kSync1:
+        m_eState = kSync2;
+        return c == UBX_SYNC1 ? kPending : kBad;
+    case kSync2:
+        m_eState = kClass;
+        return c == UBX_SYNC2 ? kPending : kBad;
+    case kClass:
+        oFrame.nClass = c;
+        m_eState      = kId;
+        break;
+    case kId:
+        oFrame.nId = c;
+        m_eState   = kLenLo;
+        break;
+    case kLenLo:
+        oFrame.nPayloadLen = c;
+        m_eState           = kLenHi;
+        break;
+    case kLenHi:
+        oFrame.nPayloadLen |= c << 8;
+        if (oFrame.nPayloadLen > UBX_MAX_PAYLOAD)
+        {
+            return kOverlength;
+        }
+        m_eState = oFrame.nPayloadLen ? kPayload : kCkA;
+        break;
+    case kPayload:
+        if (oFrame.nLen == UBX_HEADER_LEN + oFrame.nPayloadLen)
+        {
+            m_eState = kCkA;
+        }
+        break;
+    case kCkA:
+        m_eState = kCkB;
+        return c == m_nCkA ? kPending : kBad;
+    case kCkB:
+        m_eState = kSync1;
+        return c == m_nCkB ? kFrame : kBad;
+    }
+    return kPending;
+}
+
+eGNSSystem ubx_gnss_system(uint8_t nGnssId)
+{
+    switch (nGnssId)
+    {
+    case 0: // GPS
+    case 1: // SBAS
+        return kSystemGPS;
+    case 2:
+        return kSystemGalileo;
+    case 3:
+        return kSystemBeiDou;
+    case 5:
+        return kSystemQZSS;
+    case 6:
+        return kSystemGLONASS;
+    case 7:
+        return kSystemNavIC;
+    default:
+        return kSystemUnknown;
+    }
+}
+
+size_t ubx_build(uint8_t* pOut, size_t nMax, uint8_t nClass, uint8_t nId, const uint8_t* pPayload, uint16_t nPayloadLen)
+{
+    size_t nLen = UBX_HEADER_LEN + nPayloadLen + 2;
+    if (nLen > nMax)
+    {
+        return 0;
+    }
+    pOut[0] = UBX_SYNC1;
+    pOut[1] = UBX_SYNC2;
+    pOut[2] = nClass;
+    pOut[3] = nId;
+    pOut[4] = nPayloadLen & 0xff;
+    pOut[5] = nPayloadLen >> 8;
+    if (nPayloadLen)
+    {
+        memcpy(pOut + UBX_HEADER_LEN, pPayload, nPayloadLen);
+    }
+
+    uint8_t nCkA = 0;
+    uint8_t nCkB = 0;
+    for (size_t i = 2; i < nLen - 2; ++i)
+    {
+        nCkA += pOut[i];
+        nCkB += nCkA;
+    }
+    pOut[nLen - 2] = nCkA;
+    pOut[nLen - 1] = nCkB;
+    return nLen;
+}
+
+size_t ubx_cfg_prt_uart(uint8_t* pOut, size_t nMax, uint32_t nBaudRate)
+{
+    uint8_t aPayload[20] = {};
+    aPayload[0]          = 1;    // portID UART1
+    aPayload[4]          = 0xD0; // mode 8 bits, no parity, 1 stop bit
+    aPayload[5]          = 0x08;
+    aPayload[8]          = nBaudRate & 0xff;
+    aPayload[9]          = (nBaudRate >> 8) & 0xff;
+    aPayload[10]         = (nBaudRate >> 16) & 0xff;
+    aPayload[11]         = (nBaudRate >> 24) & 0xff;
+    aPayload[12]         = 0x03; // inProtoMask UBX | NMEA
+    aPayload[14]         = 0x01; // outProtoMask UBX
+    return ubx_build(pOut, nMax, UBX_CLASS_CFG, UBX_CFG_PRT, aPayload, sizeof(aPayload));
+}
+
+size_t ubx_cfg_msg(uint8_t* pOut, size_t nMax, uint8_t nClass, uint8_t nId, uint8_t nRate)
+{
+    uint8_t aPayload[3] = {nClass, nId, nRate};
+    return ubx_build(pOut, nMax, UBX_CLASS_CFG, UBX_CFG_MSG, aPayload, sizeof(aPayload));
+}
+
+size_t ubx_cfg_rate(uint8_t* pOut, size_t nMax, uint16_t nMeasRateMs)
+{
+    uint8_t aPayload[6] = {(uint8_t)(nMeasRateMs & 0xff), (uint8_t)(nMeasRateMs >> 8), 1, 0, 0, 0}; // navRate 1, timeRef UTC
+    return ubx_build(pOut, nMax, UBX_CLASS_CFG, UBX_CFG_RATE, aPayload, sizeof(aPayload));
+}
+
+UBXConfig::UBXConfig()
+    : m_pUART(nullptr),
+      m_settings(),
+      m_eState(kIdle),
+      m_nResult(0),
+      m_nBaudRate(0),
+      m_nPrevBaud(0),
+      m_bSent(false),
+      m_nAttempts(0),
+      m_nAwaitId(0),
+      m_nAck(UBX_ACK_NONE),
+      m_bHeard(false),
+      m_nSettle(0),
+      m_nDeadline(0),
+      m_nCommandLen(0),
+      m_aCommand()
+{
+}
+
+void UBXConfig::Start(uart_inst_t* pUART, const UBXSettings& settings, uint32_t nCurrentBaud)
+{
+    m_pUART     = pUART;
+    m_settings  = settings;
+    m_nResult   = (settings.nBaudRate == nCurrentBaud) ? kPortOK : 0;
+    m_nBaudRate = nCurrentBaud;
+    m_nPrevBaud = nCurrentBaud;
+    next(kMsgPVT);
+}
+
+void UBXConfig::OnFrame(const UBXFrame& oFrame, uint64_t nNow)
+{
+    if (m_eState == kPort && m_bSent && nNow >= m_nSettle)
+    {
+        // Anything that passes its checksum was sent at the new rate
+        m_bHeard = true;
+    }
+    if (oFrame.nClass == UBX_CLASS_ACK && (oFrame.nId == UBX_ACK_ACK || oFrame.nId == UBX_ACK_NAK) && oFrame.nPayloadLen >= 2 &&
+        oFrame.Payload()[0] == UBX_CLASS_CFG && oFrame.Payload()[1] == m_nAwaitId)
+    {
+        m_nAck = oFrame.nId;
+    }
+}
+
+void UBXConfig::Step(uint64_t nNow)
+{
+    switch (m_eState)
+    {
+    case kMsgPVT:
+        stepAck(nNow, kPVTOK, kMsgSAT);
+        break;
+    case kMsgSAT:
+        stepAck(nNow, kSATOK, kRate);
+        break;
+    case kRate:
+        stepAck(nNow, kRateOK, m_settings.nBaudRate != m_nBaudRate ? kPort : kDone);
+        break;
+    case kPort:
+        if (!m_bSent)
+        {
+            // The module switches once the frame is in, and its ACK may be
+            // lost in the change, so follow as soon as it is out and wait
+            // for clean frames instead
+            send();
+            uart_tx_wait_blocking(m_pUART);
+            uart_set_baudrate(m_pUART, m_settings.nBaudRate);
+            m_bSent     = true;
+            m_bHeard    = false;
+            m_nSettle   = nNow + UBX_BAUD_SETTLE_US;
+            m_nDeadline = nNow + UBX_BAUD_TIMEOUT_US;
+        }
+        else if (m_bHeard)
+        {
+            m_nBaudRate = m_settings.nBaudRate;
+            m_nResult |= kPortOK;
+            next(kDone);
+        }
+        else if (nNow >= m_nDeadline)
+        {
+            // Either the module did not follow or the link does not work at
+            // this rate.  Ask it back in case it did, then go back ourselves.
+            m_nCommandLen = ubx_cfg_prt_uart(m_aCommand, sizeof(m_aCommand), m_nPrevBaud);
+            send();
+            uart_tx_wait_blocking(m_pUART);
+            uart_set_baudrate(m_pUART, m_nPrevBaud);
+            next(kDone);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void UBXConfig::next(eState eNext)
+{
+    m_eState    = eNext;
+    m_bSent     = false;
+    m_nAttempts = 0;
+    m_nAck      = UBX_ACK_NONE;
+    switch (eNext)
+    {
+    case kMsgPVT:
+        m_nAwaitId    = UBX_CFG_MSG;
+        m_nCommandLen = ubx_cfg_msg(m_aCommand, sizeof(m_aCommand), UBX_CLASS_NAV, UBX_NAV_PVT, 1);
+        break;
+    case kMsgSAT:
+        m_nAwaitId    = UBX_CFG_MSG;
+        m_nCommandLen = ubx_cfg_msg(m_aCommand, sizeof(m_aCommand), UBX_CLASS_NAV, UBX_NAV_SAT, 1);
+        break;
+    case kRate:
+        m_nAwaitId    = UBX_CFG_RATE;
+        m_nCommandLen = ubx_cfg_rate(m_aCommand, sizeof(m_aCommand), m_settings.nMeasRateMs);
+        break;
+    case kPort:
+        m_nAwaitId    = UBX_CFG_PRT;
+        m_nCommandLen = ubx_cfg_prt_uart(m_aCommand, sizeof(m_aCommand), m_settings.nBaudRate);
+        break;
+    case kDone:
+        printf("UBX configuration: %u baud, %u ms, result %x\n", (unsigned)m_nBaudRate, (unsigned)m_settings.nMeasRateMs, m_nResult);
+        break;
+    default:
+        break;
+    }
+}
+
+void UBXConfig::send()
+{
+    uart_write_blocking(m_pUART, m_aCommand, m_nCommandLen);
+}
+
+void UBXConfig::stepAck(uint64_t nNow, uint8_t nOK, eState eNext)
+{
+    // Retry on silence, give up on a NAK
+    bool bRetry = m_nAck == UBX_ACK_NONE && nNow >= m_nDeadline;
+    if (!m_bSent || (bRetry && m_nAttempts < UBX_ACK_ATTEMPTS))
+    {
+        m_nAck = UBX_ACK_NONE;
+        send();
+        ++m_nAttempts;
+        m_bSent     = true;
+        m_nDeadline = nNow + UBX_ACK_TIMEOUT_US;
+    }
+    else if (m_nAck == UBX_ACK_ACK)
+    {
+        m_nResult |= nOK;
+        next(eNext);
+    }
+    else if (bRetry || m_nAck == UBX_ACK_NAK)
+    {
+        // Leave the module as it was
+        next(eNext);
+    }
+}
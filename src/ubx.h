@@ -0,0 +1,235 @@
+/*
+ * u-blox UBX protocol helpers
+ *
+ * (c) 2025 Erik Tkal
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hardware/uart.h>
+
+#include "nmea.h"
+
+auto constexpr UBX_SYNC1       = 0xB5;
+auto constexpr UBX_SYNC2       = 0x62;
+auto constexpr UBX_HEADER_LEN  = 6;    // sync, class, id, length
+auto constexpr UBX_MAX_PAYLOAD = 1024; // NAV-SAT with 84 satellites, larger frames are dropped
+auto constexpr UBX_MAX_FRAME   = UBX_HEADER_LEN + UBX_MAX_PAYLOAD + 2; // plus checksum
+
+auto constexpr UBX_MAX_COMMAND     = 32;      // CFG-PRT, the longest frame sent
+auto constexpr UBX_ACK_TIMEOUT_US  = 1000000; // ACK-ACK comes within a second
+auto constexpr UBX_ACK_ATTEMPTS    = 3;
+auto constexpr UBX_BAUD_TIMEOUT_US = 1500000; // time to hear a clean frame at the new rate
+auto constexpr UBX_BAUD_SETTLE_US  = 50000;   // bytes sent before the switch are still draining
+
+// Message classes and IDs
+auto constexpr UBX_CLASS_NAV = 0x01;
+auto constexpr UBX_CLASS_ACK = 0x05;
+auto constexpr UBX_CLASS_CFG = 0x06;
+auto constexpr UBX_NAV_PVT   = 0x07;
+auto constexpr UBX_NAV_SAT   = 0x35;
+auto constexpr UBX_ACK_NAK   = 0x00;
+auto constexpr UBX_ACK_ACK   = 0x01;
+auto constexpr UBX_ACK_NONE  = 0xff; // UBXConfig, nothing received yet
+auto constexpr UBX_CFG_PRT   = 0x00;
+auto constexpr UBX_CFG_MSG   = 0x01;
+auto constexpr UBX_CFG_RATE  = 0x08;
+
+// NAV-PVT payload offsets, M8 protocol 15+ and later
+auto constexpr UBX_PVT_LEN      = 92;
+auto constexpr UBX_PVT_HOUR     = 8;
+auto constexpr UBX_PVT_MIN      = 9;
+auto constexpr UBX_PVT_SEC      = 10;
+auto constexpr UBX_PVT_VALID    = 11; // bit 1 validTime
+auto constexpr UBX_PVT_FIX_TYPE = 20; // 2 = 2D, 3 = 3D, 4 = GNSS + dead reckoning
+auto constexpr UBX_PVT_FLAGS    = 21; // bit 0 gnssFixOK
+auto constexpr UBX_PVT_NUM_SV   = 23;
+auto constexpr UBX_PVT_LON      = 24; // 1e-7 degrees
+auto constexpr UBX_PVT_LAT      = 28; // 1e-7 degrees
+auto constexpr UBX_PVT_HMSL     = 36; // mm above mean sea level
+auto constexpr UBX_PVT_GSPEED   = 60; // mm/s
+
+// NAV-SAT payload offsets
+auto constexpr UBX_SAT_NUM_SVS   = 5;
+auto constexpr UBX_SAT_BLOCK     = 8;  // first satellite block
+auto constexpr UBX_SAT_BLOCK_LEN = 12; // gnssId, svId, cno, elev, azim(2), prRes(2), flags(4)
+auto constexpr UBX_SAT_USED      = 0x08; // flags bit 3 svUsed
+
+// Little-endian field readers
+static inline uint16_t ubx_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+static inline uint32_t ubx_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static inline int32_t ubx_i32(const uint8_t* p)
+{
+    return (int32_t)ubx_u32(p);
+}
+
+// One received frame, sync to checksum, so it can be echoed as is
+struct UBXFrame
+{
+    uint8_t nClass;
+    uint8_t nId;
+    uint16_t nPayloadLen;
+    uint16_t nLen;       // bytes in aData
+    uint64_t nTimestamp; // time_us_64() when the RX path completed it
+    uint8_t aData[UBX_MAX_FRAME];
+
+    const uint8_t* Payload() const
+    {
+        return aData + UBX_HEADER_LEN;
+    }
+};
+
+// UBXParser
+//
+// Streaming frame decoder in the same style as NMEAParser: bytes go
+// straight into the caller's UBXFrame and the 8-bit Fletcher checksum over
+// class, id, length and payload is accumulated on the fly.
+//
+class UBXParser
+{
+public:
+    typedef enum eResult
+    {
+        kPending,
+        kFrame,      // the target holds a complete frame with a good checksum
+        kBad,        // bad sync or checksum
+        kOverlength, // payload larger than UBX_MAX_PAYLOAD
+    } eResult;
+
+    UBXParser()
+        : m_pFrame(nullptr),
+          m_eState(kSync1),
+          m_nCkA(0),
+          m_nCkB(0)
+    {
+    }
+
+    // Start a new frame in pFrame, the first byte fed must be UBX_SYNC1
+    void Begin(UBXFrame* pFrame);
+    eResult Feed(uint8_t c);
+
+private:
+    typedef enum eState
+    {
+        kSync1,
+        kSync2,
+        kClass,
+        kId,
+        kLenLo,
+        kLenHi,
+        kPayload,
+        kCkA,
+        kCkB,
+    } eState;
+
+    UBXFrame* m_pFrame;
+    eState m_eState;
+    uint8_t m_nCkA;
+    uint8_t m_nCkB;
+};
+
+// NAV-SAT gnssId to the NMEA system it is reported under
+eGNSSystem ubx_gnss_system(uint8_t nGnssId);
+
+// Build a frame into pOut, returning its length or 0 if it does not fit
+size_t ubx_build(uint8_t* pOut, size_t nMax, uint8_t nClass, uint8_t nId, const uint8_t* pPayload, uint16_t nPayloadLen);
+
+// Configuration frames for u-blox 6/7/8 class modules, which also accept
+// them in legacy mode on M9/M10.  Each returns the frame length.
+// UART1 at nBaudRate 8N1, accepting UBX and NMEA, sending only UBX
+size_t ubx_cfg_prt_uart(uint8_t* pOut, size_t nMax, uint32_t nBaudRate);
+// Output nClass/nId on the current port once every nRate navigation solutions, 0 disables
+size_t ubx_cfg_msg(uint8_t* pOut, size_t nMax, uint8_t nClass, uint8_t nId, uint8_t nRate);
+// Navigation solution every nMeasRateMs, aligned to UTC
+size_t ubx_cfg_rate(uint8_t* pOut, size_t nMax, uint16_t nMeasRateMs);
+
+struct UBXSettings
+{
+    uint32_t nBaudRate;
+    uint16_t nMeasRateMs; // navigation solution interval
+};
+
+// UBXConfig
+//
+// Sequences the switch of a u-blox module to UBX output from the GPS
+// thread, as PMTKConfig does for MediaTek modules: NAV-PVT and NAV-SAT on,
+// then the measurement rate, each confirmed by ACK-ACK and retried on
+// silence, then the port last, while the module still listens at the old
+// rate.  The port change is confirmed by clean frames at the new rate, and
+// undone if none arrive.
+//
+class UBXConfig
+{
+public:
+    typedef enum eState
+    {
+        kIdle,
+        kMsgPVT,
+        kMsgSAT,
+        kRate,
+        kPort,
+        kDone,
+    } eState;
+
+    // Result() bits
+    auto static constexpr kPVTOK  = 0x01;
+    auto static constexpr kSATOK  = 0x02;
+    auto static constexpr kRateOK = 0x04;
+    auto static constexpr kPortOK = 0x08;
+
+    UBXConfig();
+
+    void Start(uart_inst_t* pUART, const UBXSettings& settings, uint32_t nCurrentBaud);
+    // Call with every frame that passed its checksum while Busy()
+    void OnFrame(const UBXFrame& oFrame, uint64_t nNow);
+    // Advance the sequence, call at least every few milliseconds while Busy()
+    void Step(uint64_t nNow);
+
+    bool Busy() const
+    {
+        return m_eState != kIdle && m_eState != kDone;
+    }
+    eState State() const
+    {
+        return m_eState;
+    }
+    uint8_t Result() const
+    {
+        return m_nResult;
+    }
+    uint32_t BaudRate() const
+    {
+        return m_nBaudRate;
+    }
+
+private:
+    void next(eState eNext);
+    void send();
+    void stepAck(uint64_t nNow, uint8_t nOK, eState eNext);
+
+    uart_inst_t* m_pUART;
+    UBXSettings m_settings;
+    eState m_eState;
+    uint8_t m_nResult;
+    uint32_t m_nBaudRate; // what we believe the module is using
+    uint32_t m_nPrevBaud;
+    bool m_bSent;         // current step's frame is out
+    uint8_t m_nAttempts;
+    uint8_t m_nAwaitId;   // CFG message expected in ACK-ACK or ACK-NAK
+    uint8_t m_nAck;       // UBX_ACK_ACK, UBX_ACK_NAK or UBX_ACK_NONE
+    bool m_bHeard;        // clean frame since the baud switch settled
+    uint64_t m_nSettle;
+    uint64_t m_nDeadline;
+    size_t m_nCommandLen;
+    uint8_t m_aCommand[UBX_MAX_COMMAND]; // current step's frame
+};